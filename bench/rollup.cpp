@@ -0,0 +1,105 @@
+// Checks Rollup buckets against a plain pass over the days, and times
+// both, for every resolution over a long random series.
+//
+// usage: bench-rollup [days] [iterations]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "rollup.h"
+
+using namespace std::chrono;
+
+// The first day of the bucket holding d, by walking the calendar.
+static sys_days bucket_start(sys_days d, Resolution resolution) {
+    year_month_day ymd{d};
+    switch (resolution) {
+        case Resolution::WEEK:
+            return d - days(weekday{d}.iso_encoding() - 1);
+        case Resolution::MONTH:
+            return sys_days{ymd.year() / ymd.month() / 1};
+        case Resolution::YEAR:
+            return sys_days{ymd.year() / January / 1};
+        default:
+            return d;
+    }
+}
+
+static std::vector<Bucket> plain_buckets(sys_days start,
+                                         std::vector<int> const& counts,
+                                         Resolution resolution) {
+    std::vector<Bucket> ret;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        auto b = bucket_start(start + days(i), resolution);
+        if (ret.empty() || ret.back().start != b) {
+            ret.push_back({b, 0});
+        }
+        ret.back().count += counts[i];
+    }
+    return ret;
+}
+
+template <typename F>
+static double time_us(int iterations, F&& f) {
+    auto begin = steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        f();
+    }
+    return duration<double, std::micro>(steady_clock::now() - begin)
+               .count() /
+           iterations;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 7305;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> commits{0, 12};
+    std::vector<int> counts(n);
+    for (auto& c : counts) {
+        c = commits(rng) > 8 ? commits(rng) : 0;
+    }
+    sys_days start{2005y / March / 17};
+    Rollup rollup{start, counts};
+
+    int failures = 0;
+    std::printf("resolution,buckets,rollup_us,plain_us\n");
+    const char* names[] = {"day", "week", "month", "year"};
+    for (auto resolution : {Resolution::DAY, Resolution::WEEK,
+                            Resolution::MONTH, Resolution::YEAR}) {
+        auto expected = plain_buckets(start, counts, resolution);
+        auto got = rollup.buckets(resolution);
+        bool same = got.size() == expected.size();
+        for (std::size_t i = 0; same && i < got.size(); i++) {
+            same = got[i].start == expected[i].start &&
+                   got[i].count == expected[i].count;
+        }
+        if (!same) {
+            std::fprintf(stderr, "%s: buckets differ from the plain sum\n",
+                         names[static_cast<int>(resolution)]);
+            failures++;
+        }
+        std::size_t sink = 0;
+        auto fast = time_us(iterations, [&] {
+            sink += rollup.buckets(resolution).size();
+        });
+        auto plain = time_us(iterations, [&] {
+            sink += plain_buckets(start, counts, resolution).size();
+        });
+        std::printf("%s,%zu,%.2f,%.2f\n",
+                    names[static_cast<int>(resolution)], got.size(), fast,
+                    plain);
+        if (sink == 0) {
+            std::printf("\n");
+        }
+    }
+    if (rollup.total() != sum_counts(counts.data(), counts.size())) {
+        std::fprintf(stderr, "total differs from sum_counts\n");
+        failures++;
+    }
+    return failures == 0 ? 0 : 1;
+}
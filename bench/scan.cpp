@@ -0,0 +1,189 @@
+// Times the per-commit work of a scan over the commits of a repository,
+// held in memory: every kernel the scan options can pick, against a plain
+// loop doing the common case (author pattern, commit count, day buckets)
+// by hand, then the walk with every merge policy. An option left off must
+// cost nothing, so the common kernel should match the plain loop. Fails
+// when their counts differ.
+//
+// usage: bench-scan <repo> [branch] [author pattern] [iterations]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "glob.h"
+#include "identity.h"
+#include "repository.h"
+#include "scan_kernel.h"
+#include "utils.h"
+#include "walk.h"
+
+struct Window {
+    std::chrono::sys_days start;
+    std::chrono::sys_days end;
+    std::int64_t first_day;
+    std::uint64_t days;
+};
+
+// The fastest of `iterations` runs of f(), in nanoseconds per commit.
+template <typename F>
+static double best_ns(int iterations, std::size_t commits, F&& f) {
+    double best = std::numeric_limits<double>::max();
+    auto n = static_cast<double>(std::max<std::size_t>(commits, 1));
+    for (int i = 0; i < iterations; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - begin;
+        best = std::min(best, elapsed.count() / n);
+    }
+    return best;
+}
+
+// Each run starts from a cold identity cache, as a scan does.
+template <typename Kernel>
+static DayCounts time_kernel(char const* name,
+                             std::vector<git_commit_ptr> const& commits,
+                             EmailMatcher const& matcher, Window const& w,
+                             int iterations) {
+    DayCounts counts;
+    auto ns = best_ns(iterations, commits.size(), [&] {
+        std::vector<ScanTally> tallies;
+        tallies.push_back(
+            {DayCounts{w.start, w.end}, IdentityCache{nullptr, matcher}});
+        Kernel kernel{tallies, w.first_day, w.days};
+        for (auto const& commit : commits) {
+            kernel(0, commit.get());
+        }
+        counts = std::move(tallies[0].counts);
+    });
+    std::printf("%s,%zu,%.1f\n", name, commits.size(), ns);
+    return counts;
+}
+
+// The common case written out, without policies.
+static DayCounts time_plain(std::vector<git_commit_ptr> const& commits,
+                            EmailMatcher const& matcher, Window const& w,
+                            int iterations) {
+    DayCounts counts;
+    auto ns = best_ns(iterations, commits.size(), [&] {
+        DayCounts c{w.start, w.end};
+        IdentityCache identities{nullptr, matcher};
+        for (auto const& commit : commits) {
+            auto local = local_time(git_commit_time(commit.get()),
+                                    git_commit_time_offset(commit.get()));
+            auto day = local.day - w.first_day;
+            if (static_cast<std::uint64_t>(day) >= w.days) {
+                continue;
+            }
+            auto const* author = git_commit_author(commit.get());
+            if (!identities[identities.id(author->name, author->email)]
+                     .matched) {
+                continue;
+            }
+            c.counts[day]++;
+            c.punchcard[local.weekday][local.hour]++;
+        }
+        counts = std::move(c);
+    });
+    std::printf("plain,%zu,%.1f\n", commits.size(), ns);
+    return counts;
+}
+
+static int run(char const* path, std::string const& branch,
+               std::string const& pattern, int iterations) {
+    Repository repository{path};
+    auto graph = repository.commit_graph();
+    std::vector<git_oid> tips{repository.resolve(branch)};
+    auto repo = repository.acquire();
+
+    WalkOptions everything;
+    everything.since = std::numeric_limits<std::int64_t>::min();
+    everything.until = std::numeric_limits<std::int64_t>::max();
+    std::vector<git_commit_ptr> commits;
+    auto first = std::numeric_limits<std::int64_t>::max();
+    auto last = std::numeric_limits<std::int64_t>::min();
+    walk_history(repo.get(), graph.get(), tips, everything,
+                 [&](git_commit* commit) {
+                     git_commit* copy{nullptr};
+                     if (0 != git_commit_dup(&copy, commit)) {
+                         return;
+                     }
+                     commits.emplace_back(copy);
+                     auto day = local_time(git_commit_time(commit),
+                                           git_commit_time_offset(commit))
+                                    .day;
+                     first = std::min(first, day);
+                     last = std::max(last, day);
+                 });
+    if (commits.empty()) {
+        std::fprintf(stderr, "no commits in %s\n", path);
+        return 1;
+    }
+    std::chrono::sys_days start{std::chrono::days(first)};
+    Window w{start, start + std::chrono::days(last - first), first,
+             static_cast<std::uint64_t>(last - first + 1)};
+    EmailMatcher matcher{pattern};
+
+    std::printf("case,commits,ns_per_commit\n");
+    auto plain = time_plain(commits, matcher, w, iterations);
+    auto common =
+        time_kernel<ScanKernel<AuthorFilter, CommitCount, DayBuckets, false>>(
+            "author", commits, matcher, w, iterations);
+    time_kernel<ScanKernel<CoauthorFilter<false>, CommitCount, DayBuckets,
+                           false>>("author+coauthors", commits, matcher, w,
+                                   iterations);
+    time_kernel<ScanKernel<AuthorFilter, CommitCount, AuthorBuckets, false>>(
+        "author+by-author", commits, matcher, w, iterations);
+    time_kernel<ScanKernel<CoauthorFilter<true>, CommitCount, AuthorBuckets,
+                           false>>("author+coauthors+by-author", commits,
+                                   matcher, w, iterations);
+
+    // The walk alone, per commit it visits.
+    for (auto first_parent : {false, true}) {
+        for (auto no_merges : {false, true}) {
+            WalkOptions options = everything;
+            options.first_parent = first_parent;
+            options.no_merges = no_merges;
+            std::size_t visited = 0;
+            auto count = [&](git_commit*) { visited++; };
+            walk_history(repo.get(), graph.get(), tips, options, count);
+            auto n = visited;
+            auto ns = best_ns(iterations, n, [&] {
+                walk_history(repo.get(), graph.get(), tips, options, count);
+            });
+            std::printf("walk%s%s,%zu,%.1f\n",
+                        first_parent ? "+first-parent" : "",
+                        no_merges ? "+no-merges" : "", n, ns);
+        }
+    }
+
+    if (common.counts != plain.counts || common.punchcard != plain.punchcard) {
+        std::fprintf(stderr, "kernel counts differ from the plain loop\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr,
+                     "usage: bench-scan <repo> [branch] [author pattern] "
+                     "[iterations]\n");
+        return 2;
+    }
+    try {
+        return run(argv[1], argc > 2 ? argv[2] : "HEAD",
+                   argc > 3 ? argv[3] : "",
+                   argc > 4 ? std::atoi(argv[4]) : 20);
+    } catch (std::exception const& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+}
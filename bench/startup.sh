@@ -0,0 +1,86 @@
+#!/usr/bin/env bash
+# Time to exit of git-heatmap for a cached `--socket` query against a warm
+# `serve`, for `--help`, and for a direct scan for reference, on a small
+# generated repository. Prints one CSV row per case and appends the rows
+# to <out.csv> when given.
+#
+# usage: bench/startup.sh <git-heatmap> [runs] [out.csv]
+set -euo pipefail
+
+bin=${1:?usage: startup.sh <git-heatmap> [runs] [out.csv]}
+runs=${2:-50}
+out=${3:-}
+
+work=$(mktemp -d)
+server=
+cleanup() {
+    if [[ -n $server ]]; then
+        kill "$server" 2>/dev/null || true
+        wait "$server" 2>/dev/null || true
+    fi
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+now_us() {
+    if [[ -n ${EPOCHREALTIME:-} ]]; then
+        local t=${EPOCHREALTIME/[.,]/}
+        echo "${t#0}"
+    else
+        echo $(($(date +%s%N) / 1000))
+    fi
+}
+
+repo=$work/repo
+git init -q "$repo"
+git -C "$repo" config user.name bench
+git -C "$repo" config user.email bench@example.com
+day=$(($(date +%s) - 300 * 86400))
+for i in $(seq 1 300); do
+    GIT_AUTHOR_DATE="@$((day + i * 86400)) +0000" \
+        GIT_COMMITTER_DATE="@$((day + i * 86400)) +0000" \
+        git -C "$repo" commit -q --allow-empty -m "commit $i"
+done
+
+socket=$work/heatmap.sock
+"$bin" serve --socket "$socket" &
+server=$!
+for _ in $(seq 1 100); do
+    [[ -S $socket ]] && break
+    sleep 0.05
+done
+[[ -S $socket ]] || { echo "serve did not start" >&2; exit 1; }
+# The first query scans; the timed ones are answered from the cache.
+"$bin" --socket "$socket" --format json "$repo" >/dev/null
+
+# measure <case> <command>...: runs the command $runs times.
+measure() {
+    local name=$1
+    shift
+    local times=()
+    for _ in $(seq 1 "$runs"); do
+        local start
+        start=$(now_us)
+        "$@" >/dev/null
+        times+=($(($(now_us) - start)))
+    done
+    printf '%s\n' "${times[@]}" | awk -v name="$name" -v runs="$runs" '
+        { sum += $1; if (NR == 1 || $1 < min) min = $1 }
+        END { printf "%s,%d,%.2f,%.2f\n", name, runs, sum / NR / 1000,
+                     min / 1000 }'
+}
+
+results=$(
+    echo "case,runs,mean_ms,min_ms"
+    measure socket-cached "$bin" --socket "$socket" --format json "$repo"
+    measure help "$bin" --help
+    measure scan "$bin" --format json "$repo"
+)
+echo "$results"
+if [[ -n $out ]]; then
+    if [[ -s $out ]]; then
+        echo "$results" | tail -n +2 >>"$out"
+    else
+        echo "$results" >"$out"
+    fi
+fi
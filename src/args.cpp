@@ -1,7 +1,12 @@
 
 #include "args.h"
 
+#include <map>
+#include <string_view>
+#include <vector>
+
 #include "argparse/argparse.hpp"
+#include "debug.h"
 #include "glob.h"
 #include "terminal.h"
 
@@ -9,10 +14,46 @@
 // --days
 // --since
 // --until
-// --include-merges
-// --no-merges
 
-Args::Args() : parser_("git-heatmap", "Git Contribution Heatmap") {
+template <typename Table>
+static std::vector<std::string> choice_names(Table const& table) {
+    std::vector<std::string> ret;
+    for (auto const& entry : table) {
+        ret.emplace_back(entry.name);
+    }
+    return ret;
+}
+
+// Whether argv asks for --help, possibly inside a cluster of short flags.
+// A false positive only costs the help text.
+static bool help_requested(int argc, const char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg{argv[i]};
+        if (arg == "--") {
+            break;
+        }
+        if (arg == "--help" || (arg.size() > 1 && arg[0] == '-' &&
+                                arg[1] != '-' &&
+                                arg.find('h') != std::string_view::npos)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void check_resolution(std::string const& resolution,
+                             std::string const& format) {
+    if (resolution != "day" && format != "ndjson" && format != "csv") {
+        throw std::invalid_argument(
+            "--resolution only applies to --format ndjson or csv");
+    }
+}
+
+Args::Args() : parser_("git-heatmap", "Git Contribution Heatmap") {}
+
+// Options are declared on parse() rather than in the constructor, so that
+// the help-only parts are skipped on every other run.
+void Args::define(bool describe_choices) {
     parser_.add_flag("h,help", "show help info", this->show_help_info_);
     parser_.add_option("repo", "git repository path", this->repo_path_)
         .value_placeholder("dir");
@@ -27,52 +68,159 @@ Args::Args() : parser_("git-heatmap", "Git Contribution Heatmap") {
         .hidden();
     parser_.add_option("b,branch", "branch name", this->branch_)
         .default_value("HEAD");
-    parser_.add_option("scheme", "color scheme", this->scheme_)
-        .default_value("default")
-        .choices([](auto const& scheme) {
-            std::vector<std::string> ret;
-            for (auto& [key, value] : scheme) {
-                ret.push_back(key);
-            }
-            return ret;
-        }(ColorScheme::default_schemes))
-        .choices_description([](auto const& scheme) {
-            std::map<std::string, std::string> ret;
-            for (auto& [key, value] : scheme) {
-                ret[key] = Terminal::show_example(key, "square");
-            }
-            return ret;
-        }(ColorScheme::default_schemes));
-    parser_
-        .add_option("glyph", "heatmap glyph", this->glyph_)
+    auto& scheme =
+        parser_.add_option("scheme", "color scheme", this->scheme_)
+            .default_value("default")
+            .choices(choice_names(ColorScheme::default_schemes));
+    auto& glyph = parser_.add_option("glyph", "heatmap glyph", this->glyph_)
 #ifdef _WIN32
-        .default_value("fisheye")
+                      .default_value("fisheye")
 #else
-        .default_value("square")
+                      .default_value("square")
 #endif
-        .choices([](auto const& blocks) {
-            std::vector<std::string> ret;
-            for (auto& [key, block] : blocks) {
-                ret.push_back(key);
-            }
-            return ret;
-        }(ColorScheme::blocks))
+                      .choices(choice_names(ColorScheme::blocks));
+    // The colored examples are only worth rendering for --help.
+    if (describe_choices) {
+        std::map<std::string, std::string> schemes;
+        for (auto const& entry : ColorScheme::default_schemes) {
+            std::string name{entry.name};
+            schemes[name] = Terminal::show_example(name, "square");
+        }
+        scheme.choices_description(schemes);
+        std::map<std::string, std::string> glyphs;
+        for (auto const& entry : ColorScheme::blocks) {
+            std::string name{entry.name};
+            glyphs[name] = Terminal::show_example2("default", name);
+        }
+        glyph.choices_description(glyphs);
+    }
+
+    parser_.add_option("source", "what to count", this->source_)
+        .default_value("commits")
+        .choices({"commits", "reflog"})
         .choices_description(
-            [](std::map<std::string, std::pair<const char*, const char*>> const&
-                   blocks) {
-                std::map<std::string, std::string> ret;
-                for (auto& [key, block] : blocks) {
-                    ret[key] = Terminal::show_example2("default", key);
-                }
-                return ret;
-            }(ColorScheme::blocks));
+            {{"commits", "commits reachable from the branch"},
+             {"reflog", "reflog entries of this clone and its worktrees"}});
+    parser_.add_option("view", "terminal view", this->view_)
+        .default_value("heatmap")
+        .choices({"heatmap", "punchcard"});
+    parser_.add_option("format", "output format", this->format_)
+        .default_value("terminal")
+        .choices({"terminal", "json", "ndjson", "csv", "bin"});
+    parser_
+        .add_option("resolution", "rows per day, week, month or year",
+                    this->resolution_)
+        .default_value("day")
+        .choices({"day", "week", "month", "year"});
+    parser_
+        .add_option("o,output", "write the export to a file (default: stdout)",
+                    this->output_)
+        .value_placeholder("file");
+    parser_
+        .add_option("emit-partial",
+                    "write a partial for `git-heatmap merge` instead",
+                    this->emit_partial_)
+        .value_placeholder("file");
+    parser_
+        .add_option("repo-id",
+                    "name of the repository in the partial "
+                    "(default: its origin URL)",
+                    this->repo_id_)
+        .value_placeholder("id");
+    parser_.add_flag("by-author", "also count per matching author email",
+                     this->by_author_);
+    parser_.add_flag("include-coauthors",
+                     "also credit Co-authored-by trailers",
+                     this->include_coauthors_);
+    parser_.add_flag("first-parent", "follow only the first parent of merges",
+                     this->first_parent_);
+    parser_.add_flag("no-merges", "skip merge commits", this->no_merges_);
+    parser_
+        .add_option("mailmap", "extra mailmap file, over the repository's",
+                    this->mailmap_)
+        .value_placeholder("file");
+    parser_.add_flag("no-mailmap", "match raw author emails",
+                     this->no_mailmap_);
+    parser_.add_flag("recurse-submodules",
+                     "also scan checked out submodules at their commit",
+                     this->recurse_submodules_);
+    parser_.add_flag("include-worktrees",
+                     "also walk the HEADs of linked worktrees",
+                     this->include_worktrees_);
+    parser_.add_flag("by-repo", "also count per submodule", this->by_repo_);
+    parser_
+        .add_option("j,jobs", "repositories scanned in parallel",
+                    this->jobs_)
+        .value_placeholder("n");
+    parser_
+        .add_option("threads", "threads walking one history (0: one per core)",
+                    this->threads_)
+        .value_placeholder("n")
+        .default_value("1");
+    parser_
+        .add_option("prefetch", "commit reads started ahead (default: off)",
+                    this->prefetch_)
+        .value_placeholder("depth");
+    parser_
+        .add_option("socket", "query a running `git-heatmap serve`",
+                    this->socket_)
+        .value_placeholder("path");
 
     parser_.add_flag("d,debug", "enable debug mode", this->debug_).hidden();
     parser_.add_positional("repository", "alias of --repo", this->repo_path_);
 }
 void Args::parse(int argc, const char* argv[]) {
+    define(help_requested(argc, argv));
     parser_.parse(argc, argv);
+    set_debug_enabled(this->debug_);
 
+    if (this->source_ == "reflog" &&
+        (this->recurse_submodules_ || !this->socket_.empty())) {
+        throw std::invalid_argument(
+            "--source reflog cannot be combined with --recurse-submodules "
+            "or --socket");
+    }
+    // Every reflog of the clone and its worktrees is read, by one thread
+    // and without a walk; entries have no parents, trailers or mailmap.
+    if (this->source_ == "reflog" &&
+        (this->branch_ != "HEAD" || this->first_parent_ || this->no_merges_ ||
+         this->include_coauthors_ || this->no_mailmap_ ||
+         !this->mailmap_.empty() || this->by_repo_ || this->jobs_ != 0 ||
+         this->threads_ != 1 || this->prefetch_ != 0)) {
+        throw std::invalid_argument(
+            "--source reflog only takes --repo, --author, --by-author and "
+            "--include-worktrees among the scan options");
+    }
+    // The server protocol carries the repository, branch, author and
+    // range only; anything else would be silently ignored.
+    if (!this->socket_.empty() &&
+        (this->first_parent_ || this->no_merges_ ||
+         this->include_coauthors_ || this->no_mailmap_ ||
+         !this->mailmap_.empty() || this->by_author_ || this->by_repo_ ||
+         this->recurse_submodules_ || this->include_worktrees_ ||
+         this->jobs_ != 0 || this->threads_ != 1 || this->prefetch_ != 0)) {
+        throw std::invalid_argument(
+            "--socket only takes --repo, --branch and --author among the "
+            "scan options");
+    }
+    if (!this->emit_partial_.empty() &&
+        (this->source_ == "reflog" || !this->socket_.empty())) {
+        throw std::invalid_argument(
+            "--emit-partial cannot be combined with --source reflog or "
+            "--socket");
+    }
+    if (!this->repo_id_.empty() && this->emit_partial_.empty()) {
+        throw std::invalid_argument("--repo-id requires --emit-partial");
+    }
+    check_resolution(this->resolution_, this->format_);
+    if (this->no_mailmap_ && !this->mailmap_.empty()) {
+        throw std::invalid_argument(
+            "--mailmap and --no-mailmap are mutually exclusive");
+    }
+    if (this->jobs_ < 0 || this->threads_ < 0 || this->prefetch_ < 0) {
+        throw std::invalid_argument(
+            "--jobs, --threads and --prefetch must be >= 0");
+    }
     if (!this->email_pattern_.empty() &&
         !is_valid_glob_pattern(this->email_pattern_)) {
         throw std::invalid_argument("Invalid email pattern: " +
@@ -80,6 +228,80 @@ void Args::parse(int argc, const char* argv[]) {
     }
 }
 
+ServeArgs::ServeArgs()
+    : parser_("git-heatmap serve", "Serve heatmaps over a Unix socket") {
+    parser_.add_flag("h,help", "show help info", this->show_help_info_);
+    parser_.add_option("socket", "Unix socket path to listen on", this->socket_)
+        .value_placeholder("path");
+    parser_
+        .add_option("threads", "worker threads (default: one per core)",
+                    this->threads_)
+        .value_placeholder("n");
+    parser_
+        .add_option("cache-size", "cached results kept in memory",
+                    this->cache_size_)
+        .value_placeholder("n")
+        .default_value("256");
+    parser_.add_flag("d,debug", "enable debug mode", this->debug_).hidden();
+}
+void ServeArgs::parse(int argc, const char* argv[]) {
+    parser_.parse(argc, argv);
+    set_debug_enabled(this->debug_);
+
+    if (!this->show_help_info_ && this->socket_.empty()) {
+        throw std::invalid_argument("--socket is required");
+    }
+    if (this->threads_ < 0 || this->cache_size_ < 0) {
+        throw std::invalid_argument("--threads and --cache-size must be >= 0");
+    }
+}
+
+MergeArgs::MergeArgs()
+    : parser_("git-heatmap merge", "Merge partials of a sharded scan") {
+    parser_.add_flag("h,help", "show help info", this->show_help_info_);
+    parser_.add_option("scheme", "color scheme", this->scheme_)
+        .default_value("default")
+        .choices(choice_names(ColorScheme::default_schemes));
+    parser_.add_option("glyph", "heatmap glyph", this->glyph_)
+#ifdef _WIN32
+        .default_value("fisheye")
+#else
+        .default_value("square")
+#endif
+        .choices(choice_names(ColorScheme::blocks));
+    parser_.add_option("view", "terminal view", this->view_)
+        .default_value("heatmap")
+        .choices({"heatmap", "punchcard"});
+    parser_.add_option("format", "output format", this->format_)
+        .default_value("terminal")
+        .choices({"terminal", "json", "ndjson", "csv", "bin"});
+    parser_
+        .add_option("resolution", "rows per day, week, month or year",
+                    this->resolution_)
+        .default_value("day")
+        .choices({"day", "week", "month", "year"});
+    parser_
+        .add_option("o,output", "write the export to a file (default: stdout)",
+                    this->output_)
+        .value_placeholder("file");
+    parser_
+        .add_option("emit-partial", "write the merged partial instead",
+                    this->emit_partial_)
+        .value_placeholder("file");
+    parser_.add_flag("d,debug", "enable debug mode", this->debug_).hidden();
+    parser_.add_positional("partials", "files written by --emit-partial",
+                           this->partials_);
+}
+void MergeArgs::parse(int argc, const char* argv[]) {
+    parser_.parse(argc, argv);
+    set_debug_enabled(this->debug_);
+
+    if (!this->show_help_info_ && this->partials_.empty()) {
+        throw std::invalid_argument("No partial to merge");
+    }
+    check_resolution(this->resolution_, this->format_);
+}
+
 Args& GetArgs() {
     static Args args;
     return args;
@@ -5,11 +5,11 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "argparse/argparse.hpp"
 #include "utils.h"
 
-std::chrono::hours timezon_offset();
 class Args;
 Args& GetArgs();
 class Args {
@@ -37,10 +37,64 @@ class Args {
     std::string branch_{"HEAD"};
     std::string scheme_{"default"};
     std::string glyph_{"square"};
+    std::string socket_{};
+    std::string format_{"terminal"};
+    std::string view_{"heatmap"};
+    std::string resolution_{"day"};
+    std::string source_{"commits"};
+    std::string output_{};
+    std::string mailmap_{};
+    std::string emit_partial_{};
+    std::string repo_id_{};
+    bool by_author_{false};
+    bool by_repo_{false};
+    bool include_coauthors_{false};
+    bool recurse_submodules_{false};
+    bool include_worktrees_{false};
+    bool first_parent_{false};
+    bool no_merges_{false};
+    bool no_mailmap_{false};
+    int jobs_{0};
+    int threads_{1};
+    int prefetch_{0};
     int weeks_{MAX_DISPLAY_WEEKS};
     bool show_help_info_{false};
     bool debug_{false};
     void parse(int argc, const char* argv[]);
+
+   private:
+    void define(bool describe_choices);
+};
+
+// `git-heatmap serve --socket <path>`
+class ServeArgs {
+   public:
+    ServeArgs();
+    argparse::ArgParser parser_;
+    std::string socket_{};
+    int threads_{0};
+    int cache_size_{256};
+    bool show_help_info_{false};
+    bool debug_{false};
+    void parse(int argc, const char* argv[]);
+};
+
+// `git-heatmap merge <partial>...`
+class MergeArgs {
+   public:
+    MergeArgs();
+    argparse::ArgParser parser_;
+    std::vector<std::string> partials_{};
+    std::string scheme_{"default"};
+    std::string glyph_{"square"};
+    std::string format_{"terminal"};
+    std::string view_{"heatmap"};
+    std::string resolution_{"day"};
+    std::string output_{};
+    std::string emit_partial_{};
+    bool show_help_info_{false};
+    bool debug_{false};
+    void parse(int argc, const char* argv[]);
 };
 
 #endif  // __GIT_HEATMAP_ARGS_H__
@@ -0,0 +1,255 @@
+#include "commit_graph.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+constexpr std::size_t HASH_SIZE = 20;
+constexpr std::size_t COMMIT_DATA_SIZE = HASH_SIZE + 16;
+constexpr std::uint32_t GRAPH_PARENT_NONE = 0x70000000;
+constexpr std::uint32_t GRAPH_EXTRA_EDGES = 0x80000000;
+constexpr std::uint32_t GRAPH_LAST_EDGE = 0x80000000;
+
+constexpr std::uint32_t chunk_id(const char (&id)[5]) {
+    return static_cast<std::uint32_t>(id[0]) << 24 |
+           static_cast<std::uint32_t>(id[1]) << 16 |
+           static_cast<std::uint32_t>(id[2]) << 8 |
+           static_cast<std::uint32_t>(id[3]);
+}
+
+std::uint32_t get_be32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) << 24 |
+           static_cast<std::uint32_t>(p[1]) << 16 |
+           static_cast<std::uint32_t>(p[2]) << 8 |
+           static_cast<std::uint32_t>(p[3]);
+}
+
+std::uint64_t get_be64(const unsigned char* p) {
+    return static_cast<std::uint64_t>(get_be32(p)) << 32 | get_be32(p + 4);
+}
+
+}  // namespace
+
+std::unique_ptr<CommitGraph> CommitGraph::open(std::string const& objects_dir) {
+    std::unique_ptr<CommitGraph> ret{new CommitGraph};
+    auto info = objects_dir + "/info/";
+
+    std::ifstream chain{info + "commit-graphs/commit-graph-chain"};
+    if (chain) {
+        std::string hash;
+        while (std::getline(chain, hash)) {
+            if (hash.empty()) {
+                continue;
+            }
+            auto file = MappedFile::open(info + "commit-graphs/graph-" +
+                                         hash + ".graph");
+            if (!file || !ret->add_layer(std::move(file))) {
+                return nullptr;
+            }
+        }
+    } else {
+        auto file = MappedFile::open(info + "commit-graph");
+        if (!file || !ret->add_layer(std::move(file))) {
+            return nullptr;
+        }
+    }
+    if (ret->layers_.empty()) {
+        return nullptr;
+    }
+    return ret;
+}
+
+bool CommitGraph::add_layer(std::unique_ptr<MappedFile> file) {
+    auto const* p = file->data();
+    auto size = file->size();
+    // "CGPH", version 1, hash version 1 (SHA-1), chunks, base graphs.
+    if (size < 8 || std::memcmp(p, "CGPH", 4) != 0 || p[4] != 1 ||
+        p[5] != 1 || p[7] != layers_.size()) {
+        return false;
+    }
+    std::size_t chunks = p[6];
+    if (size < 8 + (chunks + 1) * 12) {
+        return false;
+    }
+
+    Layer layer;
+    layer.base = size_;
+    std::size_t oids_size = 0;
+    std::size_t data_size = 0;
+    std::size_t generation_size = 0;
+    for (std::size_t i = 0; i < chunks; i++) {
+        auto const* entry = p + 8 + i * 12;
+        auto id = get_be32(entry);
+        auto offset = get_be64(entry + 4);
+        auto next = get_be64(entry + 16);
+        if (offset > next || next > size) {
+            return false;
+        }
+        auto const* chunk = p + offset;
+        auto chunk_size = static_cast<std::size_t>(next - offset);
+        if (id == chunk_id("OIDF")) {
+            if (chunk_size != 256 * 4) {
+                return false;
+            }
+            layer.fanout = chunk;
+        } else if (id == chunk_id("OIDL")) {
+            layer.oids = chunk;
+            oids_size = chunk_size;
+        } else if (id == chunk_id("CDAT")) {
+            layer.data = chunk;
+            data_size = chunk_size;
+        } else if (id == chunk_id("EDGE")) {
+            layer.edges = chunk;
+            layer.edge_count = static_cast<std::uint32_t>(chunk_size / 4);
+        } else if (id == chunk_id("GDA2")) {
+            layer.generation_data = chunk;
+            generation_size = chunk_size;
+        } else if (id == chunk_id("GDO2")) {
+            layer.generation_overflow = chunk;
+            layer.overflow_count = static_cast<std::uint32_t>(chunk_size / 8);
+        }
+    }
+    if (!layer.fanout || !layer.oids || !layer.data) {
+        return false;
+    }
+    layer.count = get_be32(layer.fanout + 255 * 4);
+    for (std::size_t i = 1; i < 256; i++) {
+        if (get_be32(layer.fanout + (i - 1) * 4) >
+            get_be32(layer.fanout + i * 4)) {
+            return false;
+        }
+    }
+    if (oids_size != layer.count * HASH_SIZE ||
+        data_size != layer.count * COMMIT_DATA_SIZE) {
+        return false;
+    }
+    if (!layer.generation_data || generation_size != layer.count * 4) {
+        layer.generation_data = nullptr;
+        corrected_dates_ = false;
+    }
+
+    size_ += layer.count;
+    layer.file = std::move(file);
+    layers_.push_back(std::move(layer));
+    return true;
+}
+
+CommitGraph::Layer const& CommitGraph::layer(std::uint32_t pos) const {
+    for (auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
+        if (pos >= it->base) {
+            return *it;
+        }
+    }
+    return layers_.front();
+}
+
+const unsigned char* CommitGraph::commit_data(std::uint32_t pos) const {
+    auto const& l = layer(pos);
+    return l.data + (pos - l.base) * COMMIT_DATA_SIZE;
+}
+
+std::optional<std::uint32_t> CommitGraph::find(git_oid const& oid) const {
+    auto const* raw = oid.id;
+    for (auto const& l : layers_) {
+        std::uint32_t lo =
+            raw[0] == 0 ? 0 : get_be32(l.fanout + (raw[0] - 1) * 4);
+        std::uint32_t hi = get_be32(l.fanout + raw[0] * 4);
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            auto cmp = std::memcmp(l.oids + mid * HASH_SIZE, raw, HASH_SIZE);
+            if (cmp == 0) {
+                return l.base + mid;
+            }
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+git_oid CommitGraph::oid(std::uint32_t pos) const {
+    auto const& l = layer(pos);
+    git_oid ret;
+    git_oid_fromraw(&ret, l.oids + (pos - l.base) * HASH_SIZE);
+    return ret;
+}
+
+std::int64_t CommitGraph::commit_time(std::uint32_t pos) const {
+    auto const* d = commit_data(pos) + HASH_SIZE + 8;
+    return static_cast<std::int64_t>(
+        static_cast<std::uint64_t>(get_be32(d) & 0x3) << 32 | get_be32(d + 4));
+}
+
+std::uint32_t CommitGraph::generation(std::uint32_t pos) const {
+    return get_be32(commit_data(pos) + HASH_SIZE + 8) >> 2;
+}
+
+std::int64_t CommitGraph::corrected_date(std::uint32_t pos) const {
+    if (!corrected_dates_) {
+        return commit_time(pos);
+    }
+    auto const& l = layer(pos);
+    auto offset = get_be32(l.generation_data + (pos - l.base) * 4);
+    if ((offset & 0x80000000) != 0) {
+        if ((offset & 0x7fffffff) >= l.overflow_count) {
+            return commit_time(pos);
+        }
+        return commit_time(pos) +
+               static_cast<std::int64_t>(get_be64(
+                   l.generation_overflow + (offset & 0x7fffffff) * 8));
+    }
+    return commit_time(pos) + offset;
+}
+
+std::uint32_t CommitGraph::first_parent(std::uint32_t pos) const {
+    auto const& l = layer(pos);
+    auto parent = get_be32(commit_data(pos) + HASH_SIZE);
+    // Also excludes GRAPH_PARENT_NONE.
+    return parent < l.base + l.count ? parent : NO_PARENT;
+}
+
+template <typename F>
+void CommitGraph::for_each_parent(std::uint32_t pos, F&& f) const {
+    auto first = first_parent(pos);
+    if (first == NO_PARENT) {
+        return;
+    }
+    f(first);
+    auto const& l = layer(pos);
+    auto const limit = l.base + l.count;
+    auto second = get_be32(commit_data(pos) + HASH_SIZE + 4);
+    if ((second & GRAPH_EXTRA_EDGES) == 0) {
+        if (second < limit) {
+            f(second);
+        }
+        return;
+    }
+    for (auto edge = second & ~GRAPH_EXTRA_EDGES; edge < l.edge_count;
+         edge++) {
+        auto parent = get_be32(l.edges + std::size_t{edge} * 4);
+        if ((parent & ~GRAPH_LAST_EDGE) >= limit) {
+            return;
+        }
+        f(parent & ~GRAPH_LAST_EDGE);
+        if ((parent & GRAPH_LAST_EDGE) != 0) {
+            return;
+        }
+    }
+}
+
+std::uint32_t CommitGraph::parent_count(std::uint32_t pos) const {
+    std::uint32_t count = 0;
+    for_each_parent(pos, [&count](std::uint32_t) { count++; });
+    return count;
+}
+
+void CommitGraph::parents(std::uint32_t pos,
+                          std::vector<std::uint32_t>& out) const {
+    for_each_parent(pos, [&out](std::uint32_t parent) {
+        out.push_back(parent);
+    });
+}
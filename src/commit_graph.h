@@ -0,0 +1,81 @@
+#ifndef __GIT_HEATMAP_COMMIT_GRAPH_H__
+#define __GIT_HEATMAP_COMMIT_GRAPH_H__
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <git2.h>
+
+#include "mapped_file.h"
+
+// Read-only view of git's commit-graph file, or of a split commit-graph
+// chain, giving parents, commit times and generation numbers of the
+// commits it covers without inflating any object. Commits newer than the
+// last `git commit-graph write` are simply not found.
+//
+// Positions are global across the layers of a chain, as in the file
+// format, with the base layer first.
+class CommitGraph {
+   public:
+    static constexpr std::uint32_t NO_PARENT = 0xffffffff;
+
+    // nullptr when the repository has no usable commit-graph.
+    static std::unique_ptr<CommitGraph> open(std::string const& objects_dir);
+
+    std::uint32_t size() const { return size_; }
+
+    std::optional<std::uint32_t> find(git_oid const& oid) const;
+    git_oid oid(std::uint32_t pos) const;
+
+    // Committer time, seconds since the epoch, UTC.
+    std::int64_t commit_time(std::uint32_t pos) const;
+    // Topological level: one more than the highest parent level.
+    std::uint32_t generation(std::uint32_t pos) const;
+    // Whether every layer records corrected commit dates (GDA2).
+    bool has_corrected_dates() const { return corrected_dates_; }
+    // Never less than the commit time, always greater than the corrected
+    // date of every parent, so it bounds all ancestors from above.
+    std::int64_t corrected_date(std::uint32_t pos) const;
+
+    // Parents are positions in the same or lower layers. Parents a corrupt
+    // file points past those, or past its EDGE chunk, are left out, which
+    // ends the walk of that branch instead of reading out of bounds.
+    std::uint32_t parent_count(std::uint32_t pos) const;
+    std::uint32_t first_parent(std::uint32_t pos) const;
+    // Appends the parent positions of a commit, in order.
+    void parents(std::uint32_t pos, std::vector<std::uint32_t>& out) const;
+
+   private:
+    struct Layer {
+        std::unique_ptr<MappedFile> file;
+        std::uint32_t base{0};  // commits in the layers below
+        std::uint32_t count{0};
+        const unsigned char* fanout{nullptr};
+        const unsigned char* oids{nullptr};
+        const unsigned char* data{nullptr};
+        const unsigned char* edges{nullptr};
+        std::uint32_t edge_count{0};
+        const unsigned char* generation_data{nullptr};
+        const unsigned char* generation_overflow{nullptr};
+        std::uint32_t overflow_count{0};
+    };
+
+    CommitGraph() = default;
+    bool add_layer(std::unique_ptr<MappedFile> file);
+    Layer const& layer(std::uint32_t pos) const;
+    const unsigned char* commit_data(std::uint32_t pos) const;
+    // Calls f with each parent position; defined in the .cpp, its only
+    // user.
+    template <typename F>
+    void for_each_parent(std::uint32_t pos, F&& f) const;
+
+   private:
+    std::vector<Layer> layers_;
+    std::uint32_t size_{0};
+    bool corrected_dates_{true};
+};
+
+#endif  // __GIT_HEATMAP_COMMIT_GRAPH_H__
@@ -0,0 +1,39 @@
+#include "counts.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "rollup.h"
+
+static void merge_series(std::vector<DaySeries>& into,
+                         std::vector<DaySeries> const& from) {
+    for (auto const& series : from) {
+        auto it = std::find_if(into.begin(), into.end(),
+                               [&series](DaySeries const& s) {
+                                   return s.name == series.name;
+                               });
+        if (it == into.end()) {
+            into.push_back(series);
+            continue;
+        }
+        add_counts(it->counts.data(), series.counts.data(),
+                   std::min(it->counts.size(), series.counts.size()));
+    }
+}
+
+void DayCounts::merge(DayCounts const& other) {
+    if (other.start_days != start_days || other.end_days != end_days) {
+        throw std::invalid_argument("Cannot merge counts of different ranges");
+    }
+    add_counts(counts.data(), other.counts.data(), counts.size());
+    for (std::size_t day = 0; day < punchcard.size(); day++) {
+        add_counts(punchcard[day].data(), other.punchcard[day].data(),
+                   punchcard[day].size());
+    }
+    merge_series(authors, other.authors);
+    merge_series(repos, other.repos);
+}
+
+int DayCounts::total(std::vector<int> const& series) {
+    return static_cast<int>(sum_counts(series.data(), series.size()));
+}
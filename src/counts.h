@@ -0,0 +1,47 @@
+#ifndef __GIT_HEATMAP_COUNTS_H__
+#define __GIT_HEATMAP_COUNTS_H__
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Commit counters per day of one author or one repository, aligned with
+// the days of the DayCounts holding it.
+struct DaySeries {
+    std::string name;
+    std::vector<int> counts;
+};
+
+// Plain result of a scan: one commit counter per day in
+// [start_days, end_days], the range always covering whole weeks.
+struct DayCounts {
+    std::chrono::sys_days start_days{std::chrono::days::zero()};
+    std::chrono::sys_days end_days{std::chrono::days::zero()};
+    std::string author;
+    std::vector<int> counts;
+    // Matching commits by weekday (0 = Monday) and hour of the day, in
+    // each commit's own time zone.
+    std::array<std::array<int, 24>, 7> punchcard{};
+    // Optional breakdowns, filled when requested by the scan.
+    std::vector<DaySeries> authors;
+    std::vector<DaySeries> repos;
+
+    DayCounts() = default;
+    DayCounts(std::chrono::sys_days start, std::chrono::sys_days end)
+        : start_days{start},
+          end_days{end},
+          counts((end - start).count() + 1, 0) {}
+
+    std::size_t size() const { return counts.size(); }
+    std::chrono::sys_days day(std::size_t index) const {
+        return start_days + std::chrono::days(index);
+    }
+    int total() const { return total(counts); }
+    // Add the counters of a result over the same range; breakdown series
+    // with the same name are added, new ones appended.
+    void merge(DayCounts const& other);
+    static int total(std::vector<int> const& series);
+};
+
+#endif  // __GIT_HEATMAP_COUNTS_H__
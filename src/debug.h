@@ -1,13 +1,23 @@
 #ifndef __GIT_HEATMAP_DEBUG_H__
 #define __GIT_HEATMAP_DEBUG_H__
 
+#include <atomic>
 #include <iostream>
 
-#include "args.h"
+inline std::atomic<bool>& debug_flag() {
+    static std::atomic<bool> enabled{false};
+    return enabled;
+}
+inline bool debug_enabled() {
+    return debug_flag().load(std::memory_order_relaxed);
+}
+inline void set_debug_enabled(bool enabled) {
+    debug_flag().store(enabled, std::memory_order_relaxed);
+}
 
 #define DEBUG_LOG(msg)                                   \
     do {                                                 \
-        if (GetArgs().debug_) {                          \
+        if (debug_enabled()) {                           \
             std::cerr << "[DEBUG] " << msg << std::endl; \
         }                                                \
     } while (0)
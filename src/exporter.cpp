@@ -0,0 +1,324 @@
+#include "exporter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+ExportFormat export_format(std::string const& name) {
+    if (name == "json") {
+        return ExportFormat::JSON;
+    }
+    if (name == "ndjson") {
+        return ExportFormat::NDJSON;
+    }
+    if (name == "csv") {
+        return ExportFormat::CSV;
+    }
+    if (name == "bin") {
+        return ExportFormat::BINARY;
+    }
+    throw std::invalid_argument("Unknown format: " + name);
+}
+
+void OutputBuffer::flush() {
+    if (used_ == 0) {
+        return;
+    }
+    if (out_) {
+        std::fwrite(buf_, 1, used_, out_);
+    } else if (str_) {
+        str_->append(buf_, used_);
+    }
+    used_ = 0;
+}
+
+void OutputBuffer::write(std::string_view s) {
+    while (!s.empty()) {
+        if (used_ == sizeof(buf_)) {
+            flush();
+        }
+        auto n = std::min(s.size(), sizeof(buf_) - used_);
+        std::memcpy(buf_ + used_, s.data(), n);
+        used_ += n;
+        s.remove_prefix(n);
+    }
+}
+
+void OutputBuffer::write_int(long long v) {
+    reserve(24);
+    auto [ptr, ec] = std::to_chars(buf_ + used_, buf_ + sizeof(buf_), v);
+    used_ = ptr - buf_;
+}
+
+void OutputBuffer::write_u32(std::uint32_t v) {
+    reserve(4);
+    for (int i = 0; i < 4; i++) {
+        buf_[used_++] = static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+}
+
+void OutputBuffer::write_date(std::chrono::sys_days d) {
+    std::chrono::year_month_day ymd{d};
+    auto y = static_cast<int>(ymd.year());
+    auto m = static_cast<unsigned>(ymd.month());
+    auto day = static_cast<unsigned>(ymd.day());
+    reserve(10);
+    char* p = buf_ + used_;
+    p[0] = static_cast<char>('0' + y / 1000 % 10);
+    p[1] = static_cast<char>('0' + y / 100 % 10);
+    p[2] = static_cast<char>('0' + y / 10 % 10);
+    p[3] = static_cast<char>('0' + y % 10);
+    p[4] = '-';
+    p[5] = static_cast<char>('0' + m / 10);
+    p[6] = static_cast<char>('0' + m % 10);
+    p[7] = '-';
+    p[8] = static_cast<char>('0' + day / 10);
+    p[9] = static_cast<char>('0' + day % 10);
+    used_ += 10;
+}
+
+void OutputBuffer::write_json_string(std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    write('"');
+    for (char c : s) {
+        auto u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            write('\\');
+            write(c);
+        } else if (u < 0x20) {
+            write("\\u00");
+            write(hex[u >> 4]);
+            write(hex[u & 0xf]);
+        } else {
+            write(c);
+        }
+    }
+    write('"');
+}
+
+void OutputBuffer::write_csv_field(std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        write(s);
+        return;
+    }
+    write('"');
+    for (char c : s) {
+        if (c == '"') {
+            write('"');
+        }
+        write(c);
+    }
+    write('"');
+}
+
+Exporter::Exporter(ExportFormat format, std::FILE* out, Resolution resolution)
+    : format_{format}, resolution_{resolution}, out_{out} {}
+
+Exporter::Exporter(ExportFormat format, std::string* out,
+                   Resolution resolution)
+    : format_{format}, resolution_{resolution}, out_{out} {}
+
+void Exporter::display(DayCounts const& counts) {
+    switch (format_) {
+        case ExportFormat::JSON:
+            json(counts);
+            break;
+        case ExportFormat::NDJSON:
+            rows(counts, false);
+            break;
+        case ExportFormat::CSV:
+            rows(counts, true);
+            break;
+        case ExportFormat::BINARY:
+            binary(counts);
+            break;
+    }
+    out_.flush();
+}
+
+void Exporter::json(DayCounts const& counts) {
+    auto write_counts = [this](std::vector<int> const& series) {
+        out_.write("\"counts\": [");
+        for (std::size_t i = 0; i < series.size(); i++) {
+            if (i != 0) {
+                out_.write(',');
+            }
+            out_.write_int(series[i]);
+        }
+        out_.write(']');
+    };
+    auto write_series = [&](const char* key,
+                            std::vector<DaySeries> const& series) {
+        out_.write(", \"");
+        out_.write(key);
+        out_.write("\": [");
+        for (std::size_t i = 0; i < series.size(); i++) {
+            out_.write(i == 0 ? "{\"name\": " : ", {\"name\": ");
+            out_.write_json_string(series[i].name);
+            out_.write(", \"total\": ");
+            out_.write_int(DayCounts::total(series[i].counts));
+            out_.write(", ");
+            write_counts(series[i].counts);
+            out_.write('}');
+        }
+        out_.write(']');
+    };
+
+    out_.write("{\"author\": ");
+    out_.write_json_string(counts.author);
+    out_.write(", \"start\": \"");
+    out_.write_date(counts.start_days);
+    out_.write("\", \"end\": \"");
+    out_.write_date(counts.end_days);
+    out_.write("\", \"total\": ");
+    out_.write_int(counts.total());
+    out_.write(", ");
+    write_counts(counts.counts);
+    out_.write(", \"punchcard\": [");
+    for (std::size_t i = 0; i < counts.punchcard.size(); i++) {
+        out_.write(i == 0 ? "[" : ", [");
+        for (std::size_t hour = 0; hour < counts.punchcard[i].size(); hour++) {
+            if (hour != 0) {
+                out_.write(',');
+            }
+            out_.write_int(counts.punchcard[i][hour]);
+        }
+        out_.write(']');
+    }
+    out_.write(']');
+    if (!counts.authors.empty()) {
+        write_series("authors", counts.authors);
+    }
+    if (!counts.repos.empty()) {
+        write_series("repos", counts.repos);
+    }
+    out_.write("}\n");
+}
+
+void Exporter::rows(DayCounts const& counts, bool csv) {
+    auto write_row = [&](std::string_view kind, std::string_view name,
+                         std::chrono::sys_days date, long long count) {
+        if (csv) {
+            out_.write(kind);
+            out_.write(',');
+            out_.write_csv_field(name);
+            out_.write(',');
+            out_.write_date(date);
+            out_.write(',');
+        } else {
+            out_.write("{\"kind\": \"");
+            out_.write(kind);
+            out_.write("\", \"name\": ");
+            out_.write_json_string(name);
+            out_.write(", \"date\": \"");
+            out_.write_date(date);
+            out_.write("\", \"count\": ");
+        }
+        out_.write_int(count);
+        out_.write(csv ? "\n" : "}\n");
+    };
+    auto write_rows = [&](std::string_view kind, std::string_view name,
+                          std::vector<int> const& series, bool skip_empty) {
+        if (resolution_ == Resolution::DAY) {
+            for (std::size_t i = 0; i < series.size(); i++) {
+                if (!skip_empty || series[i] != 0) {
+                    write_row(kind, name, counts.day(i), series[i]);
+                }
+            }
+            return;
+        }
+        auto buckets = Rollup{counts.start_days, series}.buckets(resolution_);
+        // The buckets partition the days, so they add up to the series.
+        assert([&] {
+            std::int64_t sum = 0;
+            for (auto const& bucket : buckets) {
+                sum += bucket.count;
+            }
+            return sum == DayCounts::total(series);
+        }());
+        for (auto const& bucket : buckets) {
+            if (!skip_empty || bucket.count != 0) {
+                write_row(kind, name, bucket.start, bucket.count);
+            }
+        }
+    };
+
+    if (csv) {
+        out_.write("kind,name,date,count\n");
+    }
+    write_rows("total", counts.author, counts.counts, false);
+    for (auto const& series : counts.authors) {
+        write_rows("author", series.name, series.counts, true);
+    }
+    for (auto const& series : counts.repos) {
+        write_rows("repo", series.name, series.counts, true);
+    }
+}
+
+void Exporter::binary(DayCounts const& counts) {
+    constexpr std::uint32_t header_size = 32;
+    constexpr std::uint32_t series_entry_size = 16;
+
+    auto days = static_cast<std::uint32_t>(counts.size());
+    auto series = static_cast<std::uint32_t>(1 + counts.authors.size() +
+                                             counts.repos.size());
+    std::uint32_t names_size = static_cast<std::uint32_t>(counts.author.size());
+    for (auto const& s : counts.authors) {
+        names_size += static_cast<std::uint32_t>(s.name.size());
+    }
+    for (auto const& s : counts.repos) {
+        names_size += static_cast<std::uint32_t>(s.name.size());
+    }
+    std::uint32_t names_offset =
+        header_size + series * series_entry_size + series * days * 4;
+
+    out_.write("GHMB");
+    out_.write_u32(1);
+    out_.write_u32(names_offset + names_size);
+    out_.write_u32(static_cast<std::uint32_t>(
+        counts.start_days.time_since_epoch().count()));
+    out_.write_u32(days);
+    out_.write_u32(series);
+    out_.write_u32(names_offset);
+    out_.write_u32(0);
+
+    std::uint32_t name_offset = names_offset;
+    auto write_entry = [&](std::uint32_t kind, std::string const& name,
+                           std::vector<int> const& values) {
+        out_.write_u32(kind);
+        out_.write_u32(name_offset);
+        out_.write_u32(static_cast<std::uint32_t>(name.size()));
+        out_.write_u32(static_cast<std::uint32_t>(DayCounts::total(values)));
+        name_offset += static_cast<std::uint32_t>(name.size());
+    };
+    write_entry(0, counts.author, counts.counts);
+    for (auto const& s : counts.authors) {
+        write_entry(1, s.name, s.counts);
+    }
+    for (auto const& s : counts.repos) {
+        write_entry(2, s.name, s.counts);
+    }
+
+    auto write_values = [this](std::vector<int> const& values) {
+        for (auto v : values) {
+            out_.write_u32(static_cast<std::uint32_t>(v));
+        }
+    };
+    write_values(counts.counts);
+    for (auto const& s : counts.authors) {
+        write_values(s.counts);
+    }
+    for (auto const& s : counts.repos) {
+        write_values(s.counts);
+    }
+
+    out_.write(counts.author);
+    for (auto const& s : counts.authors) {
+        out_.write(s.name);
+    }
+    for (auto const& s : counts.repos) {
+        out_.write(s.name);
+    }
+}
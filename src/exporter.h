@@ -0,0 +1,99 @@
+#ifndef __GIT_HEATMAP_EXPORTER_H__
+#define __GIT_HEATMAP_EXPORTER_H__
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "counts.h"
+#include "renderer.h"
+#include "rollup.h"
+
+enum class ExportFormat { JSON, NDJSON, CSV, BINARY };
+
+ExportFormat export_format(std::string const& name);
+
+// Fixed size output buffer flushed to a FILE* or appended to a string when
+// full, so rows are streamed straight from the count arrays.
+class OutputBuffer {
+   public:
+    explicit OutputBuffer(std::FILE* out) : out_{out} {}
+    explicit OutputBuffer(std::string* out) : str_{out} {}
+    ~OutputBuffer() { flush(); }
+    OutputBuffer(OutputBuffer const&) = delete;
+    OutputBuffer& operator=(OutputBuffer const&) = delete;
+
+    void write(std::string_view s);
+    void write(char c) {
+        if (used_ == sizeof(buf_)) {
+            flush();
+        }
+        buf_[used_++] = c;
+    }
+    void write_int(long long v);
+    void write_u32(std::uint32_t v);
+    void write_date(std::chrono::sys_days d);
+    void write_json_string(std::string_view s);
+    void write_csv_field(std::string_view s);
+    void flush();
+
+   private:
+    void reserve(std::size_t n) {
+        if (sizeof(buf_) - used_ < n) {
+            flush();
+        }
+    }
+
+   private:
+    std::FILE* out_{nullptr};
+    std::string* str_{nullptr};
+    std::size_t used_{0};
+    char buf_[64 * 1024];
+};
+
+// Machine readable renderers.
+//
+// json:   one object on one line,
+//         {"author", "start", "end", "total", "counts": [...],
+//          "punchcard": [7 weekdays from Monday][24 hours],
+//          "authors": [{"name", "total", "counts"}], "repos": [...]}
+// ndjson: one {"kind", "name", "date", "count"} row per day of the total
+//         and per non-empty day of every author and repository.
+// csv:    the same rows as ndjson with a kind,name,date,count header.
+//         With a week, month or year resolution, ndjson and csv have one
+//         row per calendar bucket instead, dated by its first day, which
+//         may lie before "start"; edge buckets only count days in range.
+// bin:    little-endian, fixed width, to be mmapped:
+//           header (32 bytes)
+//             char[4] magic "GHMB", u32 version (1), u32 file size,
+//             i32 first day (days since 1970-01-01), u32 days,
+//             u32 series, u32 names offset, u32 reserved
+//           series table, 16 bytes per series
+//             u32 kind (0 total, 1 author, 2 repository),
+//             u32 name offset, u32 name length, u32 total
+//           counts, u32[series][days]
+//           names, UTF-8, not terminated
+//         The first series is always the total.
+class Exporter : public Renderer {
+   public:
+    explicit Exporter(ExportFormat format, std::FILE* out = stdout,
+                      Resolution resolution = Resolution::DAY);
+    explicit Exporter(ExportFormat format, std::string* out,
+                      Resolution resolution = Resolution::DAY);
+
+    void display(DayCounts const& counts) override;
+
+   private:
+    void json(DayCounts const& counts);
+    void rows(DayCounts const& counts, bool csv);
+    void binary(DayCounts const& counts);
+
+   private:
+    ExportFormat format_;
+    Resolution resolution_;
+    OutputBuffer out_;
+};
+
+#endif  // __GIT_HEATMAP_EXPORTER_H__
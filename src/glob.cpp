@@ -16,30 +16,34 @@ bool is_valid_glob_pattern(const std::string& pattern) {
     return true;
 }
 
-bool matchglob(const std::string& pattern, const std::string& name) {
-    const char* p = pattern.c_str();
-    const char* n = name.c_str();
+bool matchglob(std::string_view pattern, std::string_view name) {
+    const char* p = pattern.data();
+    const char* const pend = p + pattern.size();
+    const char* n = name.data();
+    const char* const nend = n + name.size();
     std::stack<std::pair<const char*, const char*>,
                std::vector<std::pair<const char*, const char*>>>
         backtrack;
 
     for (;;) {
         bool matching = true;
-        while (*p != '\0' && matching) {
+        while (p != pend && matching) {
             switch (*p) {
-                case '*':
+                case '*': {
                     // Step forward until we match the next character after *
-                    while (*n != '\0' && *n != p[1]) {
+                    const char next = p + 1 != pend ? p[1] : '\0';
+                    while (n != nend && *n != next) {
                         n++;
                     }
-                    if (*n != '\0') {
+                    if (n != nend) {
                         // If this isn't the last possibility, save it for later
                         backtrack.emplace(p, n);
                     }
                     break;
+                }
                 case '?':
                     // Any character matches unless we're at the end of the name
-                    if (*n != '\0') {
+                    if (n != nend) {
                         n++;
                     } else {
                         matching = false;
@@ -47,7 +51,9 @@ bool matchglob(const std::string& pattern, const std::string& name) {
                     break;
                 default:
                     // Non-wildcard characters match literally
-                    if (*n == *p) {
+                    if (n == nend) {
+                        matching = false;
+                    } else if (*n == *p) {
                         n++;
                     } else if (*n == '\\' && *p == '/') {
                         n++;
@@ -63,7 +69,7 @@ bool matchglob(const std::string& pattern, const std::string& name) {
 
         // If we haven't failed matching and we've reached the end of the name,
         // then success
-        if (matching && *n == '\0') {
+        if (matching && n == nend) {
             return true;
         }
 
@@ -83,7 +89,7 @@ bool matchglob(const std::string& pattern, const std::string& name) {
 }
 
 bool matchglobs(const std::vector<std::string>& patterns,
-                const std::string& name) {
+                std::string_view name) {
     return std::any_of(begin(patterns), end(patterns),
                        [&name](const std::string& pattern) {
                            return matchglob(pattern, name);
@@ -2,13 +2,45 @@
 #ifndef __GIT_HEATMAP_GLOB_H__
 #define __GIT_HEATMAP_GLOB_H__
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <vector>
 bool is_valid_glob_pattern(const std::string& pattern);
 
-bool matchglob(const std::string& pattern, const std::string& name);
+bool matchglob(std::string_view pattern, std::string_view name);
 
 bool matchglobs(const std::vector<std::string>& patterns,
-                const std::string& name);
+                std::string_view name);
+
+// Matches author emails against --author: a glob when the pattern holds
+// '*' or '?', a plain substring otherwise, and everything when empty.
+class EmailMatcher {
+   public:
+    EmailMatcher(std::string const& email) : email_(email) {
+        set_pattern(email);
+    }
+    bool operator()(std::string_view email) const {
+        if (email_.empty()) {
+            return true;
+        }
+        if (is_pattern_) {
+            return matchglob(email_, email);
+        }
+        return email.find(email_) != std::string_view::npos;
+    }
+
+    void set_pattern(std::string const& email) {
+        email_ = email;
+        is_pattern_ = std::any_of(email.begin(), email.end(),
+                                  [](char c) { return c == '?' || c == '*'; });
+    }
+
+    std::string const& pattern() const { return email_; }
+
+   private:
+    std::string email_;
+    bool is_pattern_{false};
+};
 
 #endif  // __GIT_HEATMAP_GLOB_H__
@@ -1,22 +1,22 @@
 #ifndef __GIT_HEATMAP_H__
 #define __GIT_HEATMAP_H__
 
-#include <chrono>
-#include <memory>
-#include <string>
+// Public entry point of libgitheatmap:
+//
+//     Repository repo{"/path/to/repo"};
+//     Scanner scanner{{.branch = "main", .start_days = s, .end_days = e}};
+//     DayCounts counts = scanner.scan(repo);
+//     Terminal{"default", "square"}.display(counts);
+//
+// Repository handles are long-lived and may be shared between threads;
+// a Scanner is immutable and may run concurrent scans.
 
-class GitHeatMap {
-   public:
-    GitHeatMap(std::string repo_path, std::string branch, std::string email,
-               std::string const& color_scheme, std::string const& glyph,
-               std::chrono::sys_days start_days,
-               std::chrono::sys_days end_days);
-    ~GitHeatMap();
-    void display();
+#include "counts.h"
+#include "renderer.h"
+#include "repository.h"
+#include "rollup.h"
+#include "scanner.h"
+#include "service.h"
+#include "terminal.h"
 
-   private:
-    class HeatMapImpl;
-    std::unique_ptr<HeatMapImpl> impl;
-};
-
-#endif  // __GIT_HEATMAP_COMMIT_CALENDAR_H__
+#endif  // __GIT_HEATMAP_H__
@@ -0,0 +1,71 @@
+#include "identity.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "debug.h"
+
+Mailmap::Mailmap(git_repository* repo, std::string const& extra_path) {
+    if (!extra_path.empty()) {
+        std::ifstream in{extra_path, std::ios::binary};
+        if (!in) {
+            throw std::runtime_error("Failed to read mailmap: " + extra_path);
+        }
+        std::string text{std::istreambuf_iterator<char>(in),
+                         std::istreambuf_iterator<char>()};
+        if (0 != git_mailmap_from_buffer(&extra_, text.data(), text.size())) {
+            throw std::runtime_error("Invalid mailmap: " + extra_path);
+        }
+    }
+    if (0 != git_mailmap_from_repository(&repo_, repo)) {
+        DEBUG_LOG("mailmap: " << git_error_last()->message);
+        repo_ = nullptr;
+    }
+}
+
+Mailmap::~Mailmap() {
+    git_mailmap_free(extra_);
+    git_mailmap_free(repo_);
+}
+
+const char* Mailmap::resolve(const char* name, const char* email) const {
+    const char* real_name = name;
+    const char* real_email = email;
+    // git_mailmap_resolve hands back the inputs when nothing matches.
+    for (auto const* mm : {extra_, repo_}) {
+        if (mm && 0 == git_mailmap_resolve(&real_name, &real_email, mm, name,
+                                           email) &&
+            real_email != email) {
+            return real_email;
+        }
+    }
+    return email;
+}
+
+IdentityCache::IdentityCache(Mailmap const* mailmap,
+                             EmailMatcher const& matcher)
+    : mailmap_{mailmap}, matcher_{matcher} {}
+
+std::uint32_t IdentityCache::id(std::string_view name,
+                                std::string_view email) {
+    key_.assign(name);
+    key_.push_back('\0');
+    key_.append(email);
+    if (auto it = raw_.find(key_); it != raw_.end()) {
+        return it->second;
+    }
+
+    // key_ holds both halves NUL-terminated, as libgit2 wants them.
+    std::string canonical = mailmap_ ? mailmap_->resolve(
+                                           key_.c_str(),
+                                           key_.c_str() + name.size() + 1)
+                                     : std::string(email);
+    auto [it, inserted] = canonical_.try_emplace(
+        canonical, static_cast<std::uint32_t>(identities_.size()));
+    if (inserted) {
+        identities_.push_back({canonical, matcher_(canonical)});
+    }
+    raw_.emplace(key_, it->second);
+    return it->second;
+}
@@ -0,0 +1,67 @@
+#ifndef __GIT_HEATMAP_IDENTITY_H__
+#define __GIT_HEATMAP_IDENTITY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <git2.h>
+
+#include "glob.h"
+
+// The repository's mailmap (.mailmap, mailmap.file and mailmap.blob) plus
+// an optional extra file whose entries win over the repository's.
+class Mailmap {
+   public:
+    // Throws when `extra_path` is given but cannot be read.
+    Mailmap(git_repository* repo, std::string const& extra_path = {});
+    ~Mailmap();
+    Mailmap(Mailmap const&) = delete;
+    Mailmap& operator=(Mailmap const&) = delete;
+
+    // The canonical email of an identity; `email` itself when unmapped.
+    const char* resolve(const char* name, const char* email) const;
+
+   private:
+    git_mailmap* extra_{nullptr};
+    git_mailmap* repo_{nullptr};
+};
+
+// Resolves raw commit identities to canonical identity IDs for one scan.
+// Every distinct raw (name, email) pair goes through the mailmap and the
+// author pattern once; later commits by the same pair are a hash lookup.
+// Raw pairs mapped to the same canonical email share one ID.
+class IdentityCache {
+   public:
+    static constexpr std::size_t NO_SERIES = static_cast<std::size_t>(-1);
+
+    struct Identity {
+        std::string email;
+        // Whether the canonical email matches the author pattern.
+        bool matched{false};
+        // Index into DayCounts::authors, once the identity was credited.
+        std::size_t series{NO_SERIES};
+    };
+
+    // A null mailmap resolves every identity to itself.
+    IdentityCache(Mailmap const* mailmap, EmailMatcher const& matcher);
+
+    std::uint32_t id(std::string_view name, std::string_view email);
+    Identity& operator[](std::uint32_t id) { return identities_[id]; }
+
+    // Distinct canonical identities seen so far.
+    std::size_t size() const { return identities_.size(); }
+
+   private:
+    Mailmap const* mailmap_;
+    EmailMatcher const& matcher_;
+    std::unordered_map<std::string, std::uint32_t> raw_;
+    std::unordered_map<std::string, std::uint32_t> canonical_;
+    std::vector<Identity> identities_;
+    std::string key_;
+};
+
+#endif  // __GIT_HEATMAP_IDENTITY_H__
@@ -0,0 +1,52 @@
+#ifndef __GIT_HEATMAP_LRU_CACHE_H__
+#define __GIT_HEATMAP_LRU_CACHE_H__
+
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+// Least recently used cache with a fixed number of entries.
+// Not synchronized: callers hold their own lock.
+template <typename Key, typename Value>
+class LruCache {
+   public:
+    explicit LruCache(std::size_t capacity) : capacity_{capacity} {}
+
+    std::optional<Value> get(Key const& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return std::nullopt;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    void put(Key const& key, Value value) {
+        if (capacity_ == 0) {
+            return;
+        }
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            it->second->second = std::move(value);
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
+        }
+        if (entries_.size() >= capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_.emplace(key, entries_.begin());
+    }
+
+    std::size_t size() const { return entries_.size(); }
+
+   private:
+    std::size_t capacity_;
+    std::list<std::pair<Key, Value>> entries_;
+    std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator>
+        index_;
+};
+
+#endif  // __GIT_HEATMAP_LRU_CACHE_H__
@@ -1,11 +1,19 @@
 #include <algorithm>
+#include <cstdio>
 #include <filesystem>
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 #include "argparse/argparse.hpp"
 #include "args.h"
 #include "debug.h"
+#include "exporter.h"
 #include "heatmap.h"
+#include "partial.h"
+#include "reflog.h"
+#include "server.h"
+#include "submodules.h"
 #include "utils.h"
 
 #if defined(__clang__) && defined(_WIN32)
@@ -18,8 +26,87 @@ static void __attribute__((__constructor__)) git_heatmap_configure_console_mode(
 }
 #endif
 
+static int serve(int argc, const char* argv[]) {
+    ServeArgs args;
+    args.parse(argc, argv);
+    if (args.show_help_info_) {
+        args.parser_.print_usage();
+        return 0;
+    }
+    Server server{{.socket_path = args.socket_,
+                   .threads = static_cast<std::size_t>(args.threads_),
+                   .cache_size = static_cast<std::size_t>(args.cache_size_)}};
+    server.run();
+    return 0;
+}
+
+using file_ptr = std::unique_ptr<std::FILE, decltype([](std::FILE* f) {
+                                     std::fclose(f);
+                                 })>;
+
+template <typename RenderArgs>
+static void render(DayCounts const& commits, RenderArgs const& args) {
+    if (args.format_ == "terminal") {
+        Terminal terminal{args.scheme_, args.glyph_,
+                          args.view_ == "punchcard" ? TerminalView::PUNCHCARD
+                                                    : TerminalView::HEATMAP};
+        terminal.display(commits);
+    } else {
+        file_ptr file{args.output_.empty()
+                          ? nullptr
+                          : std::fopen(args.output_.c_str(), "wb")};
+        if (!args.output_.empty() && !file) {
+            throw std::runtime_error("Failed to open " + args.output_);
+        }
+        Exporter exporter{export_format(args.format_),
+                          file ? file.get() : stdout,
+                          rollup_resolution(args.resolution_)};
+        exporter.display(commits);
+    }
+}
+
+static void emit_partial(std::string const& path, DayCounts const& commits,
+                         std::vector<ScannedTip> const& tips) {
+    file_ptr file{std::fopen(path.c_str(), "wb")};
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    write_partial(file.get(), commits, tips);
+}
+
+static int merge(int argc, const char* argv[]) {
+    MergeArgs args;
+    args.parse(argc, argv);
+    if (args.show_help_info_) {
+        args.parser_.print_usage();
+        return 0;
+    }
+    PartialMerger merger;
+    for (auto const& path : args.partials_) {
+        merger.add(path);
+    }
+    if (merger.units() == 0) {
+        throw std::runtime_error("No partial to merge");
+    }
+    DEBUG_LOG("merged " << merger.units() << " partial units, skipped "
+                        << merger.skipped() << " duplicates");
+    if (!args.emit_partial_.empty()) {
+        emit_partial(args.emit_partial_, merger.result(), merger.tips());
+    } else {
+        render(merger.result(), args);
+    }
+    return 0;
+}
+
 int main(int argc, const char* argv[]) {
     try {
+        if (argc > 1 && std::string_view(argv[1]) == "serve") {
+            return serve(argc - 1, argv + 1);
+        }
+        if (argc > 1 && std::string_view(argv[1]) == "merge") {
+            return merge(argc - 1, argv + 1);
+        }
+
         Args& args = GetArgs();
         args.parse(argc, argv);
 
@@ -42,10 +129,66 @@ int main(int argc, const char* argv[]) {
         auto weeks = std::clamp(args.weeks_, 4, MAX_DISPLAY_WEEKS);
         auto end_days = sunday();
         auto start_days = end_days - std::chrono::days(weeks * 7 - 1);
-        GitHeatMap heatmap(args.repo_path_, args.branch_, args.email_pattern_,
-                           args.scheme_, args.glyph_, start_days, end_days);
+        DayCounts commits;
+        std::vector<ScannedTip> tips;
+        if (!args.socket_.empty()) {
+            commits = query_server(
+                args.socket_,
+                {.repo = std::filesystem::absolute(args.repo_path_).string(),
+                 .branch = args.branch_,
+                 .author = args.email_pattern_,
+                 .start_days = start_days,
+                 .end_days = end_days});
+        } else {
+            Repository repository{args.repo_path_};
+            Scanner scanner{{.branch = args.branch_,
+                             .email_pattern = args.email_pattern_,
+                             .start_days = start_days,
+                             .end_days = end_days,
+                             .by_author = args.by_author_,
+                             .include_coauthors = args.include_coauthors_,
+                             .first_parent = args.first_parent_,
+                             .no_merges = args.no_merges_,
+                             .use_mailmap = !args.no_mailmap_,
+                             .mailmap_file = args.mailmap_,
+                             .threads = static_cast<std::size_t>(
+                                 args.threads_),
+                             .prefetch_depth = static_cast<std::size_t>(
+                                 args.prefetch_)}};
+            // Partials from different hosts name the repository alike, so
+            // the host-local git dir is only the last resort.
+            auto emit = !args.emit_partial_.empty();
+            auto id = args.repo_id_;
+            if (emit && id.empty()) {
+                id = repository.remote_url();
+            }
+            if (emit && id.empty()) {
+                id = repository.git_dir();
+            }
+            if (args.source_ == "reflog") {
+                commits = scan_reflogs(scanner, repository);
+            } else if (args.recurse_submodules_ || args.include_worktrees_) {
+                commits = scan_recursive(
+                    scanner, repository,
+                    {.submodules = args.recurse_submodules_,
+                     .worktrees = args.include_worktrees_,
+                     .by_repo = args.by_repo_,
+                     .jobs = static_cast<std::size_t>(args.jobs_),
+                     .id = id},
+                    emit ? &tips : nullptr);
+            } else if (emit) {
+                tips.push_back({id, repository.resolve(args.branch_)});
+                commits = scanner.scan(repository, tips.front().oid);
+            } else {
+                commits = scanner.scan(repository);
+            }
+        }
 
-        heatmap.display();
+        if (!args.emit_partial_.empty()) {
+            emit_partial(args.emit_partial_, commits, tips);
+        } else {
+            render(commits, args);
+        }
 
     } catch (const std::exception& e) {
         DEBUG_LOG("Error occurred: " << e.what());
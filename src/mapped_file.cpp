@@ -0,0 +1,116 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::open(std::string const& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                  FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    std::unique_ptr<MappedFile> ret{new MappedFile};
+    ret->data_ = static_cast<const unsigned char*>(data);
+    ret->size_ = static_cast<std::size_t>(size.QuadPart);
+    ret->mapping_ = mapping;
+    return ret;
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+}
+
+bool MappedFile::resident(std::size_t) const { return true; }
+
+void MappedFile::will_need(std::size_t, std::size_t) const {}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::open(std::string const& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return nullptr;
+    }
+    void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                        PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    std::unique_ptr<MappedFile> ret{new MappedFile};
+    ret->data_ = static_cast<const unsigned char*>(data);
+    ret->size_ = static_cast<std::size_t>(st.st_size);
+    return ret;
+}
+
+MappedFile::~MappedFile() {
+    ::munmap(const_cast<unsigned char*>(data_), size_);
+}
+
+static std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+bool MappedFile::resident(std::size_t offset) const {
+    if (offset >= size_) {
+        return true;
+    }
+    auto page = offset & ~(page_size() - 1);
+#if defined(__APPLE__)
+    char vec = 0;
+#else
+    unsigned char vec = 0;
+#endif
+    if (::mincore(const_cast<unsigned char*>(data_) + page, 1, &vec) != 0) {
+        return true;
+    }
+    return (vec & 1) != 0;
+}
+
+void MappedFile::will_need(std::size_t offset, std::size_t length) const {
+    if (offset >= size_) {
+        return;
+    }
+    auto page = offset & ~(page_size() - 1);
+    length = std::min(length + (offset - page), size_ - page);
+    ::madvise(const_cast<unsigned char*>(data_) + page, length,
+              MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __GIT_HEATMAP_MAPPED_FILE_H__
+#define __GIT_HEATMAP_MAPPED_FILE_H__
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+   public:
+    // nullptr when the file does not exist or cannot be mapped.
+    static std::unique_ptr<MappedFile> open(std::string const& path);
+    ~MappedFile();
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+    // Whether the page holding `offset` is in memory. Always true where
+    // the platform cannot tell.
+    bool resident(std::size_t offset) const;
+    // Start reading [offset, offset + length) into memory in the
+    // background; returns at once. A no-op where unsupported.
+    void will_need(std::size_t offset, std::size_t length) const;
+
+   private:
+    MappedFile() = default;
+
+   private:
+    const unsigned char* data_{nullptr};
+    std::size_t size_{0};
+#ifdef _WIN32
+    void* mapping_{nullptr};
+#endif
+};
+
+#endif  // __GIT_HEATMAP_MAPPED_FILE_H__
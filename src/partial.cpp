@@ -0,0 +1,326 @@
+#include "partial.h"
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include "debug.h"
+
+namespace {
+
+constexpr char MAGIC[4] = {'G', 'H', 'M', 'P'};
+constexpr std::uint16_t VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 16;
+constexpr std::size_t OID_SIZE = 20;
+// Well above any real section; a larger size means a corrupt file.
+constexpr std::uint32_t MAX_SECTION = 1u << 28;
+constexpr std::uint32_t MAX_DAYS = 1u << 20;
+
+enum SeriesKind : std::uint8_t { ALL = 0, AUTHOR = 1, REPO = 2 };
+
+constexpr auto CRC_TABLE = [] {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; i++) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+// CRC-32 as in zlib; pass the previous value to continue a checksum.
+std::uint32_t crc32(std::string_view data, std::uint32_t crc = 0) {
+    crc = ~crc;
+    for (auto c : data) {
+        crc = CRC_TABLE[(crc ^ static_cast<unsigned char>(c)) & 0xff] ^
+              (crc >> 8);
+    }
+    return ~crc;
+}
+
+void put_u16(std::string& out, std::uint16_t v) {
+    out += static_cast<char>(v & 0xff);
+    out += static_cast<char>(v >> 8);
+}
+
+void put_u32(std::string& out, std::uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out += static_cast<char>((v >> (8 * i)) & 0xff);
+    }
+}
+
+std::uint32_t get_u32(const char* p) {
+    auto const* u = reinterpret_cast<const unsigned char*>(p);
+    return static_cast<std::uint32_t>(u[0]) |
+           static_cast<std::uint32_t>(u[1]) << 8 |
+           static_cast<std::uint32_t>(u[2]) << 16 |
+           static_cast<std::uint32_t>(u[3]) << 24;
+}
+
+// Starts a section and returns where its size goes, once known.
+std::size_t begin_section(std::string& out, char tag) {
+    out += tag;
+    put_u32(out, 0);
+    return out.size() - 4;
+}
+
+void end_section(std::string& out, std::size_t at) {
+    auto size = static_cast<std::uint32_t>(out.size() - at - 4);
+    for (int i = 0; i < 4; i++) {
+        out[at + i] = static_cast<char>((size >> (8 * i)) & 0xff);
+    }
+}
+
+void put_series(std::string& out, SeriesKind kind, std::string const& name,
+                std::vector<int> const& counts) {
+    auto at = begin_section(out, 'S');
+    out += static_cast<char>(kind);
+    put_u32(out, static_cast<std::uint32_t>(name.size()));
+    out += name;
+    auto n_at = out.size();
+    put_u32(out, 0);
+    std::uint32_t n = 0;
+    for (std::size_t day = 0; day < counts.size(); day++) {
+        if (counts[day] != 0) {
+            put_u32(out, static_cast<std::uint32_t>(day));
+            put_u32(out, static_cast<std::uint32_t>(counts[day]));
+            n++;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        out[n_at + i] = static_cast<char>((n >> (8 * i)) & 0xff);
+    }
+    end_section(out, at);
+}
+
+// Reads a payload field by field, failing on a truncated one.
+class Fields {
+   public:
+    Fields(std::string const& path, std::string_view data)
+        : path_{path}, data_{data} {}
+
+    std::string_view take(std::size_t n) {
+        if (data_.size() < n) {
+            throw std::runtime_error("Corrupt partial: " + path_);
+        }
+        auto ret = data_.substr(0, n);
+        data_.remove_prefix(n);
+        return ret;
+    }
+    std::uint8_t u8() { return static_cast<std::uint8_t>(take(1)[0]); }
+    std::uint32_t u32() { return get_u32(take(4).data()); }
+    std::string_view string() { return take(u32()); }
+
+   private:
+    std::string const& path_;
+    std::string_view data_;
+};
+
+std::string tip_key(ScannedTip const& tip) {
+    std::string key{tip.repo};
+    key += '\0';
+    key.append(reinterpret_cast<const char*>(tip.oid.id), OID_SIZE);
+    return key;
+}
+
+using file_ptr = std::unique_ptr<std::FILE, decltype([](std::FILE* f) {
+                                     std::fclose(f);
+                                 })>;
+
+}  // namespace
+
+void write_partial(std::FILE* out, DayCounts const& counts,
+                   std::vector<ScannedTip> const& tips) {
+    std::string unit;
+    unit.append(MAGIC, sizeof(MAGIC));
+    put_u16(unit, VERSION);
+    put_u16(unit, 0);
+    put_u32(unit, static_cast<std::uint32_t>(
+                      counts.start_days.time_since_epoch().count()));
+    put_u32(unit, static_cast<std::uint32_t>(counts.size()));
+
+    for (auto const& tip : tips) {
+        auto at = begin_section(unit, 'T');
+        put_u32(unit, static_cast<std::uint32_t>(tip.repo.size()));
+        unit += tip.repo;
+        unit.append(reinterpret_cast<const char*>(tip.oid.id), OID_SIZE);
+        end_section(unit, at);
+    }
+    auto at = begin_section(unit, 'A');
+    unit += counts.author;
+    end_section(unit, at);
+
+    put_series(unit, ALL, {}, counts.counts);
+    for (auto const& series : counts.authors) {
+        put_series(unit, AUTHOR, series.name, series.counts);
+    }
+    for (auto const& series : counts.repos) {
+        put_series(unit, REPO, series.name, series.counts);
+    }
+
+    at = begin_section(unit, 'P');
+    for (auto const& hours : counts.punchcard) {
+        for (auto n : hours) {
+            put_u32(unit, static_cast<std::uint32_t>(n));
+        }
+    }
+    end_section(unit, at);
+
+    auto crc = crc32(unit);
+    at = begin_section(unit, 'E');
+    put_u32(unit, crc);
+    end_section(unit, at);
+
+    if (std::fwrite(unit.data(), 1, unit.size(), out) != unit.size()) {
+        throw std::runtime_error("Failed to write partial");
+    }
+}
+
+void PartialMerger::add(std::string const& path) {
+    file_ptr file{std::fopen(path.c_str(), "rb")};
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path);
+    }
+    auto corrupt = [&path]() {
+        return std::runtime_error("Corrupt partial: " + path);
+    };
+    auto read = [&](std::string& buf, std::size_t n) {
+        buf.resize(n);
+        return std::fread(buf.data(), 1, n, file.get()) == n;
+    };
+
+    std::string header;
+    std::string section;
+    std::string payload;
+    while (true) {
+        header.resize(HEADER_SIZE);
+        auto got = std::fread(header.data(), 1, HEADER_SIZE, file.get());
+        if (got == 0) {
+            break;
+        }
+        if (got != HEADER_SIZE ||
+            std::memcmp(header.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::runtime_error("Not a git-heatmap partial: " + path);
+        }
+        auto version = static_cast<std::uint16_t>(
+            static_cast<unsigned char>(header[4]) |
+            static_cast<unsigned char>(header[5]) << 8);
+        if (version != VERSION) {
+            throw std::runtime_error("Unsupported partial version " +
+                                     std::to_string(version) + ": " + path);
+        }
+        auto first_day =
+            static_cast<std::int32_t>(get_u32(header.data() + 8));
+        auto days = get_u32(header.data() + 12);
+        if (days == 0 || days > MAX_DAYS) {
+            throw corrupt();
+        }
+        std::chrono::sys_days start{std::chrono::days(first_day)};
+        DayCounts unit{start, start + std::chrono::days(days - 1)};
+        std::vector<ScannedTip> tips;
+        auto crc = crc32(header);
+        bool ended = false;
+
+        while (!ended) {
+            if (!read(section, 5)) {
+                throw corrupt();
+            }
+            auto size = get_u32(section.data() + 1);
+            if (size > MAX_SECTION || !read(payload, size)) {
+                throw corrupt();
+            }
+            Fields fields{path, payload};
+            switch (section[0]) {
+                case 'T': {
+                    ScannedTip tip;
+                    tip.repo = fields.string();
+                    std::memcpy(tip.oid.id, fields.take(OID_SIZE).data(),
+                                OID_SIZE);
+                    tips.push_back(std::move(tip));
+                    break;
+                }
+                case 'A':
+                    unit.author = payload;
+                    break;
+                case 'S': {
+                    auto kind = fields.u8();
+                    std::string name{fields.string()};
+                    std::vector<int>* counts = &unit.counts;
+                    if (kind == AUTHOR || kind == REPO) {
+                        auto& into = kind == AUTHOR ? unit.authors : unit.repos;
+                        into.push_back({std::move(name),
+                                        std::vector<int>(unit.size(), 0)});
+                        counts = &into.back().counts;
+                    } else if (kind != ALL) {
+                        throw corrupt();
+                    }
+                    for (auto n = fields.u32(); n > 0; n--) {
+                        auto day = fields.u32();
+                        auto count = fields.u32();
+                        if (day >= days) {
+                            throw corrupt();
+                        }
+                        (*counts)[day] = static_cast<int>(count);
+                    }
+                    break;
+                }
+                case 'P':
+                    for (auto& hours : unit.punchcard) {
+                        for (auto& n : hours) {
+                            n = static_cast<int>(fields.u32());
+                        }
+                    }
+                    break;
+                case 'E':
+                    if (fields.u32() != crc) {
+                        throw std::runtime_error(
+                            "Checksum mismatch in partial: " + path);
+                    }
+                    ended = true;
+                    break;
+                default:
+                    break;
+            }
+            crc = crc32(section, crc);
+            crc = crc32(payload, crc);
+        }
+
+        std::size_t seen = 0;
+        for (auto const& tip : tips) {
+            seen += seen_.count(tip_key(tip));
+        }
+        if (seen > 0 && seen == tips.size()) {
+            DEBUG_LOG("Skipping duplicate partial unit in " << path);
+            skipped_++;
+            continue;
+        }
+        if (seen > 0) {
+            throw std::runtime_error(
+                "Partial overlaps the ones merged before: " + path);
+        }
+        if (empty_) {
+            result_ = std::move(unit);
+            empty_ = false;
+        } else if (unit.start_days != result_.start_days ||
+                   unit.end_days != result_.end_days) {
+            throw std::runtime_error(
+                "Partial covers other days than the ones merged before: " +
+                path);
+        } else if (unit.author != result_.author) {
+            throw std::runtime_error(
+                "Partial counts another author than the ones merged "
+                "before: " +
+                path);
+        } else {
+            result_.merge(unit);
+        }
+        for (auto& tip : tips) {
+            seen_.insert(tip_key(tip));
+            tips_.push_back(std::move(tip));
+        }
+        units_++;
+    }
+}
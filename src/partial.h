@@ -0,0 +1,71 @@
+#ifndef __GIT_HEATMAP_PARTIAL_H__
+#define __GIT_HEATMAP_PARTIAL_H__
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <git2.h>
+
+#include "counts.h"
+
+// Partial results, for a scan sharded across hosts: each shard writes the
+// counts of the repositories it scanned with `--emit-partial`, and
+// `git-heatmap merge` adds the partials up into one result.
+//
+// A partial file is a sequence of units, each the result of one scan and
+// self-contained, so that files can be concatenated. Integers are little
+// endian:
+//
+//   header   char[4] "GHMP", u16 version (1), u16 reserved (0),
+//            i32 first day (days since 1970-01-01), u32 days
+//   sections u8 tag, u32 payload size, payload; readers skip unknown tags
+//     'T'    a scanned tip: u32 size, repository id, 20-byte oid
+//     'A'    the author pattern
+//     'S'    a series: u8 kind (0 all, 1 author, 2 repository), u32 size,
+//            name, u32 n, then n (u32 day, u32 count) for non-zero days
+//     'P'    the punchcard, 7 x 24 u32 from Monday 00h
+//     'E'    end of unit: u32 CRC-32 of every byte of the unit before it
+//
+// A unit is written at once and read at once, so memory is bounded by the
+// size of one result whatever the number of partials merged.
+
+// A tip a scan walked from, the unit in which partials are deduplicated.
+// `repo` names the repository the same way on every host, such as its
+// remote URL, so that shards of one repository are recognized.
+struct ScannedTip {
+    std::string repo;
+    git_oid oid;
+};
+
+// Append `counts`, scanned from `tips`, as one unit.
+void write_partial(std::FILE* out, DayCounts const& counts,
+                   std::vector<ScannedTip> const& tips);
+
+// Adds up partials over the same range of days. A unit whose tips were
+// all merged already is a retried or duplicated shard and skipped; a unit
+// sharing only some of them cannot be told apart from the others and is
+// an error, as are corrupt files, mismatched ranges and author patterns.
+class PartialMerger {
+   public:
+    void add(std::string const& path);
+
+    // Counts so far, or an empty result when nothing was added.
+    DayCounts const& result() const { return result_; }
+    // Every tip merged so far, for writing the result as a partial again.
+    std::vector<ScannedTip> const& tips() const { return tips_; }
+    std::size_t units() const { return units_; }
+    std::size_t skipped() const { return skipped_; }
+
+   private:
+    DayCounts result_;
+    bool empty_{true};
+    std::vector<ScannedTip> tips_;
+    std::unordered_set<std::string> seen_;
+    std::size_t units_{0};
+    std::size_t skipped_{0};
+};
+
+#endif  // __GIT_HEATMAP_PARTIAL_H__
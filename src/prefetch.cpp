@@ -0,0 +1,155 @@
+#include "prefetch.h"
+
+#include <cstring>
+#include <filesystem>
+
+#include "debug.h"
+
+namespace {
+
+constexpr std::size_t HASH_SIZE = 20;
+// Commits are small; their compressed data rarely crosses this.
+constexpr std::size_t PREFETCH_BYTES = 4096;
+
+std::uint32_t get_be32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) << 24 |
+           static_cast<std::uint32_t>(p[1]) << 16 |
+           static_cast<std::uint32_t>(p[2]) << 8 |
+           static_cast<std::uint32_t>(p[3]);
+}
+
+std::uint64_t get_be64(const unsigned char* p) {
+    return static_cast<std::uint64_t>(get_be32(p)) << 32 | get_be32(p + 4);
+}
+
+}  // namespace
+
+bool PackIndex::load(std::string const& idx_path, Pack& pack) {
+    pack.idx = MappedFile::open(idx_path);
+    if (!pack.idx) {
+        return false;
+    }
+    auto const* p = pack.idx->data();
+    auto size = pack.idx->size();
+    // "\377tOc", version 2, fanout, then per object its oid, crc and
+    // offset, the 64-bit offsets and two trailing hashes.
+    constexpr std::size_t header = 8 + 256 * 4;
+    if (size < header + 2 * HASH_SIZE ||
+        std::memcmp(p, "\377tOc\0\0\0\2", 8) != 0) {
+        return false;
+    }
+    pack.fanout = p + 8;
+    pack.count = get_be32(pack.fanout + 255 * 4);
+    // prefetch() takes its search bounds from the fanout; non-decreasing
+    // up to the last entry keeps them within the object count.
+    for (std::size_t i = 1; i < 256; i++) {
+        if (get_be32(pack.fanout + (i - 1) * 4) >
+            get_be32(pack.fanout + i * 4)) {
+            return false;
+        }
+    }
+    auto fixed = header + std::size_t{pack.count} * (HASH_SIZE + 8) +
+                 2 * HASH_SIZE;
+    if (size < fixed || (size - fixed) % 8 != 0) {
+        return false;
+    }
+    pack.oids = pack.fanout + 256 * 4;
+    pack.offsets = pack.oids + std::size_t{pack.count} * (HASH_SIZE + 4);
+    pack.large_offsets = pack.offsets + std::size_t{pack.count} * 4;
+    pack.large_count = (size - fixed) / 8;
+
+    auto pack_path = idx_path.substr(0, idx_path.size() - 4) + ".pack";
+    pack.pack = MappedFile::open(pack_path);
+    return pack.pack != nullptr;
+}
+
+std::unique_ptr<PackIndex> PackIndex::open(std::string const& objects_dir) {
+    std::unique_ptr<PackIndex> ret{new PackIndex};
+    std::error_code ec;
+    for (auto const& entry : std::filesystem::directory_iterator(
+             std::filesystem::path(objects_dir) / "pack", ec)) {
+        if (entry.path().extension() != ".idx") {
+            continue;
+        }
+        Pack pack;
+        if (load(entry.path().string(), pack)) {
+            ret->packs_.push_back(std::move(pack));
+        } else {
+            DEBUG_LOG("skipping pack index " << entry.path().string());
+        }
+    }
+    if (ret->packs_.empty()) {
+        return nullptr;
+    }
+    return ret;
+}
+
+void PackIndex::prefetch(git_oid const& oid) const {
+    requested_.fetch_add(1, std::memory_order_relaxed);
+    auto const* raw = oid.id;
+    for (auto const& pack : packs_) {
+        std::uint32_t lo =
+            raw[0] == 0 ? 0 : get_be32(pack.fanout + (raw[0] - 1) * 4);
+        std::uint32_t hi = get_be32(pack.fanout + raw[0] * 4);
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            auto cmp =
+                std::memcmp(pack.oids + std::size_t{mid} * HASH_SIZE, raw,
+                            HASH_SIZE);
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else if (cmp > 0) {
+                hi = mid;
+            } else {
+                std::uint64_t offset =
+                    get_be32(pack.offsets + std::size_t{mid} * 4);
+                if ((offset & 0x80000000) != 0) {
+                    auto large = offset & 0x7fffffff;
+                    if (large >= pack.large_count) {
+                        return;
+                    }
+                    offset = get_be64(pack.large_offsets + large * 8);
+                }
+                if (pack.pack->resident(offset)) {
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    misses_.fetch_add(1, std::memory_order_relaxed);
+                    pack.pack->will_need(offset, PREFETCH_BYTES);
+                }
+                return;
+            }
+        }
+    }
+    unpacked_.fetch_add(1, std::memory_order_relaxed);
+}
+
+PackIndex::Stats PackIndex::stats() const {
+    return {requested_.load(std::memory_order_relaxed),
+            hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed),
+            unpacked_.load(std::memory_order_relaxed)};
+}
+
+void Prefetcher::want(git_oid const& oid) {
+    if (!index_) {
+        return;
+    }
+    if (in_flight_ < depth_) {
+        in_flight_++;
+        index_->prefetch(oid);
+    } else {
+        pending_.push_back(oid);
+    }
+}
+
+void Prefetcher::done() {
+    if (!index_) {
+        return;
+    }
+    if (!pending_.empty()) {
+        index_->prefetch(pending_.front());
+        pending_.pop_front();
+    } else if (in_flight_ > 0) {
+        in_flight_--;
+    }
+}
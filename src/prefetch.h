@@ -0,0 +1,87 @@
+#ifndef __GIT_HEATMAP_PREFETCH_H__
+#define __GIT_HEATMAP_PREFETCH_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <git2.h>
+
+#include "mapped_file.h"
+
+// The pack offsets of a repository's objects, read straight from the
+// objects/pack/*.idx files (version 2), with the packs mapped so that the
+// pages of an object can be requested before libgit2 reads them. On a
+// cold cache or a network file system this turns a walk's one blocking
+// random read per commit into reads the kernel runs ahead in parallel.
+class PackIndex {
+   public:
+    struct Stats {
+        std::uint64_t requested{0};
+        // The object's first page was already in memory.
+        std::uint64_t hits{0};
+        // A background read was started.
+        std::uint64_t misses{0};
+        // Not in any pack: a loose object, or a pack added since.
+        std::uint64_t unpacked{0};
+    };
+
+    // nullptr when the repository has no readable pack index.
+    static std::unique_ptr<PackIndex> open(std::string const& objects_dir);
+
+    std::size_t packs() const { return packs_.size(); }
+
+    // Start reading the object in the background unless it is resident.
+    // Returns at once; safe to call from several threads.
+    void prefetch(git_oid const& oid) const;
+
+    Stats stats() const;
+
+   private:
+    struct Pack {
+        std::unique_ptr<MappedFile> idx;
+        std::unique_ptr<MappedFile> pack;
+        std::uint32_t count{0};
+        const unsigned char* fanout{nullptr};
+        const unsigned char* oids{nullptr};
+        const unsigned char* offsets{nullptr};
+        const unsigned char* large_offsets{nullptr};
+        std::size_t large_count{0};
+    };
+
+    PackIndex() = default;
+    static bool load(std::string const& idx_path, Pack& pack);
+
+   private:
+    std::vector<Pack> packs_;
+    mutable std::atomic<std::uint64_t> requested_{0};
+    mutable std::atomic<std::uint64_t> hits_{0};
+    mutable std::atomic<std::uint64_t> misses_{0};
+    mutable std::atomic<std::uint64_t> unpacked_{0};
+};
+
+// Keeps the reads of at most `depth` objects the walk has queued but not
+// looked up yet in flight; the rest wait in order. Used by the serial
+// walk, whose queue no other thread takes from.
+class Prefetcher {
+   public:
+    Prefetcher(PackIndex const* index, std::size_t depth)
+        : index_{depth > 0 ? index : nullptr}, depth_{depth} {}
+
+    // An object the walk is going to look up.
+    void want(git_oid const& oid);
+    // The walk looked up one of the wanted objects.
+    void done();
+
+   private:
+    PackIndex const* index_;
+    std::size_t depth_;
+    std::size_t in_flight_{0};
+    std::deque<git_oid> pending_;
+};
+
+#endif  // __GIT_HEATMAP_PREFETCH_H__
@@ -0,0 +1,182 @@
+#include "reflog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "debug.h"
+#include "glob.h"
+#include "identity.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+static bool parse_int(std::string_view text, std::int64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    value = 0;
+    for (auto c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+bool parse_reflog_line(std::string_view line, ReflogEntry& entry) {
+    auto old_end = line.find(' ');
+    if (old_end == std::string_view::npos) {
+        return false;
+    }
+    auto new_end = line.find(' ', old_end + 1);
+    if (new_end == std::string_view::npos) {
+        return false;
+    }
+    entry.new_oid = line.substr(old_end + 1, new_end - old_end - 1);
+
+    auto tab = line.find('\t', new_end);
+    if (tab == std::string_view::npos) {
+        tab = line.size();
+    }
+    entry.message = line.substr(std::min(tab + 1, line.size()));
+    auto identity = line.substr(new_end + 1, tab - new_end - 1);
+    // Names may hold anything but '<' and '>', so split at the last '>'.
+    auto close = identity.rfind('>');
+    auto open = identity.rfind('<', close);
+    if (close == std::string_view::npos || open == std::string_view::npos) {
+        return false;
+    }
+    entry.name = identity.substr(0, open);
+    if (!entry.name.empty() && entry.name.back() == ' ') {
+        entry.name.remove_suffix(1);
+    }
+    entry.email = identity.substr(open + 1, close - open - 1);
+
+    // " <seconds> <+hhmm>"
+    auto when = identity.substr(close + 1);
+    if (when.size() < 8 || when[0] != ' ') {
+        return false;
+    }
+    auto space = when.find(' ', 1);
+    if (space == std::string_view::npos || when.size() != space + 6 ||
+        (when[space + 1] != '+' && when[space + 1] != '-')) {
+        return false;
+    }
+    std::int64_t tz = 0;
+    if (!parse_int(when.substr(1, space - 1), entry.time) ||
+        !parse_int(when.substr(space + 2), tz)) {
+        return false;
+    }
+    entry.offset_minutes = static_cast<int>(tz / 100 * 60 + tz % 100);
+    if (when[space + 1] == '-') {
+        entry.offset_minutes = -entry.offset_minutes;
+    }
+    return true;
+}
+
+static void list_reflogs(std::filesystem::path const& logs,
+                         std::vector<std::filesystem::path>& out) {
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(logs, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (it->is_regular_file(ec)) {
+            out.push_back(it->path());
+        }
+    }
+}
+
+DayCounts scan_reflogs(Scanner const& scanner, Repository& repository) {
+    auto const& options = scanner.options();
+    DayCounts result{options.start_days, options.end_days};
+
+    auto email_pattern = options.email_pattern;
+    if (email_pattern.empty()) {
+        email_pattern = repository.default_email();
+    }
+    EmailMatcher email_matcher{email_pattern};
+    result.author = email_pattern;
+    IdentityCache identities{nullptr, email_matcher};
+
+    std::filesystem::path git_dir{repository.git_dir()};
+    std::vector<std::filesystem::path> files;
+    list_reflogs(git_dir / "logs", files);
+    std::error_code ec;
+    for (auto it = std::filesystem::directory_iterator(git_dir / "worktrees",
+                                                       ec);
+         !ec && it != std::filesystem::directory_iterator();
+         it.increment(ec)) {
+        list_reflogs(it->path() / "logs", files);
+    }
+
+    auto const first_day = options.start_days.time_since_epoch().count();
+    auto const days = static_cast<std::uint64_t>(result.size());
+    // Keyed by everything after the old oid but the message, as views
+    // into the mappings, which stay alive until the end of the scan.
+    std::unordered_set<std::string_view> seen;
+    std::vector<std::unique_ptr<MappedFile>> mapped;
+    ReflogEntry entry;
+    std::size_t lines = 0;
+
+    for (auto const& path : files) {
+        auto file = MappedFile::open(path.string());
+        if (!file) {
+            continue;
+        }
+        std::string_view text{reinterpret_cast<const char*>(file->data()),
+                              file->size()};
+        mapped.push_back(std::move(file));
+
+        while (!text.empty()) {
+            auto const* nl = static_cast<const char*>(
+                std::memchr(text.data(), '\n', text.size()));
+            auto length =
+                nl ? static_cast<std::size_t>(nl - text.data()) : text.size();
+            auto line = text.substr(0, length);
+            text.remove_prefix(nl ? length + 1 : length);
+            lines++;
+
+            if (!parse_reflog_line(line, entry)) {
+                DEBUG_LOG("Skipping reflog line in " << path.string());
+                continue;
+            }
+            auto local = local_time(entry.time, entry.offset_minutes);
+            auto day = local.day - first_day;
+            if (static_cast<std::uint64_t>(day) >= days) {
+                continue;
+            }
+            auto id = identities.id(entry.name, entry.email);
+            auto& identity = identities[id];
+            if (!identity.matched) {
+                continue;
+            }
+            auto key_start =
+                static_cast<std::size_t>(entry.new_oid.data() - line.data());
+            auto key_end = static_cast<std::size_t>(entry.message.data() -
+                                                    line.data());
+            if (!seen.insert(line.substr(key_start, key_end - key_start))
+                     .second) {
+                continue;
+            }
+
+            result.counts[day]++;
+            result.punchcard[local.weekday][local.hour]++;
+            if (options.by_author) {
+                if (identity.series == IdentityCache::NO_SERIES) {
+                    identity.series = result.authors.size();
+                    result.authors.push_back(
+                        {identity.email, std::vector<int>(result.size(), 0)});
+                }
+                result.authors[identity.series].counts[day]++;
+            }
+        }
+    }
+    DEBUG_LOG("reflog: " << files.size() << " files, " << lines
+                         << " entries");
+    return result;
+}
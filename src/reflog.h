@@ -0,0 +1,33 @@
+#ifndef __GIT_HEATMAP_REFLOG_H__
+#define __GIT_HEATMAP_REFLOG_H__
+
+#include <cstdint>
+#include <string_view>
+
+#include "counts.h"
+#include "repository.h"
+#include "scanner.h"
+
+// One line of a reflog file:
+// "<old> <new> <name> <<email>> <seconds> <+hhmm>\t<message>\n"
+struct ReflogEntry {
+    std::string_view new_oid;
+    std::string_view name;
+    std::string_view email;
+    std::int64_t time{0};
+    int offset_minutes{0};
+    std::string_view message;
+};
+
+// Parses one line without its newline; false when it is malformed.
+bool parse_reflog_line(std::string_view line, ReflogEntry& entry);
+
+// Local activity instead of history: counts the entries of every reflog
+// of the repository and its linked worktrees (commits, amends, rebases,
+// checkouts, resets, ...) per day in their own time zone, for identities
+// matching the scanner's author pattern. The files are mapped and parsed
+// in place; no object is read and the mailmap is not applied. An update
+// logged for both HEAD and a branch counts once.
+DayCounts scan_reflogs(Scanner const& scanner, Repository& repository);
+
+#endif  // __GIT_HEATMAP_REFLOG_H__
@@ -0,0 +1,13 @@
+#ifndef __GIT_HEATMAP_RENDERER_H__
+#define __GIT_HEATMAP_RENDERER_H__
+
+#include "counts.h"
+
+// Anything that consumes the result of a scan.
+class Renderer {
+   public:
+    virtual ~Renderer() = default;
+    virtual void display(DayCounts const& counts) = 0;
+};
+
+#endif  // __GIT_HEATMAP_RENDERER_H__
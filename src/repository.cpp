@@ -0,0 +1,173 @@
+#include "repository.h"
+
+#include <stdexcept>
+
+#include "debug.h"
+#include "utils.h"
+
+LibGit2::LibGit2() { git_libgit2_init(); }
+LibGit2::~LibGit2() { git_libgit2_shutdown(); }
+
+void Repository::Releaser::operator()(git_repository* repo) const {
+    owner->release(repo);
+}
+
+Repository::Repository(std::string const& path) : path_{path} {
+    DEBUG_LOG("Opening repository: " << path_);
+    auto* repo = open();
+    git_dir_ = git_repository_commondir(repo);
+    idle_.push_back(repo);
+}
+
+Repository::~Repository() {
+    for (auto* repo : idle_) {
+        git_repository_free(repo);
+    }
+}
+
+git_repository* Repository::open() const {
+    git_repository* repo{nullptr};
+    if (git_repository_open_ext(&repo, path_.c_str(), 0, nullptr) != 0) {
+        throw std::runtime_error("Failed to open repository");
+    }
+    return repo;
+}
+
+Repository::Handle Repository::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            auto* repo = idle_.back();
+            idle_.pop_back();
+            return Handle(repo, Releaser{this});
+        }
+    }
+    return Handle(open(), Releaser{this});
+}
+
+void Repository::release(git_repository* repo) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(repo);
+}
+
+std::string Repository::config_string(const char* name) {
+    auto repo = acquire();
+    git_config_ptr config = [](git_repository* r) {
+        git_config* c{nullptr};
+        if (0 == git_repository_config_snapshot(&c, r)) {
+            return git_config_ptr(c);
+        }
+        return git_config_ptr(nullptr);
+    }(repo.get());
+    if (!config) {
+        DEBUG_LOG("git config get error.");
+        return {};
+    }
+    const char* value = nullptr;
+    if (0 != git_config_get_string(&value, config.get(), name) ||
+        nullptr == value) {
+        DEBUG_LOG(git_error_last()->message);
+        return {};
+    }
+    return value;
+}
+
+std::string Repository::default_email() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (default_email_) {
+            return *default_email_;
+        }
+    }
+    auto email = config_string("user.email");
+    std::lock_guard<std::mutex> lock(mutex_);
+    default_email_ = email;
+    return email;
+}
+
+std::string Repository::remote_url() {
+    return strip_userinfo(config_string("remote.origin.url"));
+}
+
+git_oid Repository::resolve(std::string const& branch) {
+    std::vector<std::string> refnames{};
+    if (branch.starts_with("refs/")) {
+        refnames.push_back(branch);
+    } else {
+        refnames = {branch, "refs/tags/" + branch, "refs/heads/" + branch,
+                    "refs/remotes/" + branch, "refs/remotes/origin/" + branch};
+    }
+    auto repo = acquire();
+    for (auto const& refname : refnames) {
+        git_reference_ptr ref = [](git_repository* r, const char* refname_) {
+            git_reference* ret;
+            if (0 == git_reference_lookup(&ret, r, refname_)) {
+                return git_reference_ptr(ret);
+            }
+            return git_reference_ptr(nullptr);
+        }(repo.get(), refname.c_str());
+        if (!ref) {
+            continue;
+        }
+        git_reference_ptr resolved = [](git_reference* refname_) {
+            git_reference* target;
+            if (0 == git_reference_resolve(&target, refname_)) {
+                return git_reference_ptr(target);
+            }
+            return git_reference_ptr(nullptr);
+        }(ref.get());
+        if (!resolved) {
+            continue;
+        }
+        // Annotated tags point at a tag object, peel down to the commit.
+        git_object* peeled{nullptr};
+        if (0 != git_reference_peel(&peeled, resolved.get(),
+                                    GIT_OBJECT_COMMIT)) {
+            continue;
+        }
+        git_oid oid;
+        git_oid_cpy(&oid, git_object_id(peeled));
+        git_object_free(peeled);
+        return oid;
+    }
+    throw std::runtime_error("Branch not found: " + branch);
+}
+
+std::shared_ptr<CommitGraph const> Repository::commit_graph() {
+    auto info = std::filesystem::path(git_dir_) / "objects" / "info";
+    std::error_code ec;
+    auto stamp = std::filesystem::last_write_time(
+        info / "commit-graphs" / "commit-graph-chain", ec);
+    if (ec) {
+        stamp = std::filesystem::last_write_time(info / "commit-graph", ec);
+    }
+    if (ec) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stamp != commit_graph_stamp_) {
+        commit_graph_ = CommitGraph::open(git_dir_ + "objects");
+        commit_graph_stamp_ = stamp;
+        DEBUG_LOG("commit-graph: "
+                  << (commit_graph_ ? commit_graph_->size() : 0)
+                  << " commits");
+    }
+    return commit_graph_;
+}
+
+std::shared_ptr<PackIndex const> Repository::pack_index() {
+    std::error_code ec;
+    auto stamp = std::filesystem::last_write_time(
+        std::filesystem::path(git_dir_) / "objects" / "pack", ec);
+    if (ec) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stamp != pack_index_stamp_) {
+        pack_index_ = PackIndex::open(git_dir_ + "objects");
+        pack_index_stamp_ = stamp;
+        DEBUG_LOG("pack indexes: "
+                  << (pack_index_ ? pack_index_->packs() : 0));
+    }
+    return pack_index_;
+}
@@ -0,0 +1,118 @@
+#ifndef __GIT_HEATMAP_REPOSITORY_H__
+#define __GIT_HEATMAP_REPOSITORY_H__
+
+#include <git2.h>
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "commit_graph.h"
+#include "prefetch.h"
+
+using git_repository_ptr =
+    std::unique_ptr<git_repository, decltype([](git_repository* repo) {
+                        git_repository_free(repo);
+                    })>;
+
+using git_config_ptr =
+    std::unique_ptr<git_config, decltype([](git_config* config) {
+                        git_config_free(config);
+                    })>;
+
+using git_reference_ptr =
+    std::unique_ptr<git_reference, decltype([](git_reference* ref) {
+                        git_reference_free(ref);
+                    })>;
+using git_revwalk_ptr =
+    std::unique_ptr<git_revwalk, decltype([](git_revwalk* walk) {
+                        git_revwalk_free(walk);
+                    })>;
+
+using git_commit_ptr =
+    std::unique_ptr<git_commit, decltype([](git_commit* commit) {
+                        git_commit_free(commit);
+                    })>;
+
+using git_buf_ptr =
+    std::unique_ptr<git_buf, decltype([](git_buf* buf) { git_buf_free(buf); })>;
+
+// Keeps libgit2 initialized for as long as the handle lives.
+// git_libgit2_init() is reference counted and thread-safe, so every
+// long-lived owner of libgit2 objects simply holds one of these.
+class LibGit2 {
+   public:
+    LibGit2();
+    ~LibGit2();
+    LibGit2(LibGit2 const&) = delete;
+    LibGit2& operator=(LibGit2 const&) = delete;
+};
+
+// A long-lived handle on one repository. It owns a small pool of
+// git_repository objects so that concurrent scans each get their own
+// (libgit2 objects must not be shared between threads), and caches
+// what does not change between queries.
+class Repository {
+    struct Releaser {
+        Repository* owner;
+        void operator()(git_repository* repo) const;
+    };
+
+   public:
+    using Handle = std::unique_ptr<git_repository, Releaser>;
+
+    explicit Repository(std::string const& path);
+    ~Repository();
+    Repository(Repository const&) = delete;
+    Repository& operator=(Repository const&) = delete;
+
+    // The path the handle was opened with.
+    std::string const& path() const { return path_; }
+    // The resolved git directory, stable across different spellings of
+    // the same repository path.
+    std::string const& git_dir() const { return git_dir_; }
+
+    Handle acquire();
+
+    // `git config --get user.email`, read once per handle.
+    std::string default_email();
+
+    // `git config --get remote.origin.url` without user name or password,
+    // or empty without an origin. Names the repository the same way on
+    // every clone of it, and is safe to write out.
+    std::string remote_url();
+
+    // Resolve a branch, tag or remote branch name to the commit it points
+    // to. Never cached: the tip moves while the handle lives.
+    git_oid resolve(std::string const& branch);
+
+    // The commit-graph of the object store, or nullptr. Mapped once and
+    // mapped again only when git rewrites it.
+    std::shared_ptr<CommitGraph const> commit_graph();
+
+    // The pack indexes of the object store, or nullptr. Loaded again when
+    // packs are added or removed; counters live as long as one load.
+    std::shared_ptr<PackIndex const> pack_index();
+
+   private:
+    git_repository* open() const;
+    std::string config_string(const char* name);
+    void release(git_repository* repo);
+
+   private:
+    LibGit2 libgit2_;
+    std::string path_;
+    std::string git_dir_;
+    std::mutex mutex_;
+    std::vector<git_repository*> idle_;
+    std::optional<std::string> default_email_;
+    std::shared_ptr<CommitGraph const> commit_graph_;
+    std::filesystem::file_time_type commit_graph_stamp_{};
+    std::shared_ptr<PackIndex const> pack_index_;
+    std::filesystem::file_time_type pack_index_stamp_{};
+};
+
+#endif  // __GIT_HEATMAP_REPOSITORY_H__
@@ -0,0 +1,196 @@
+#include "rollup.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GIT_HEATMAP_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GIT_HEATMAP_NEON 1
+#endif
+
+void add_counts(int* into, int const* from, std::size_t n) {
+    std::size_t i = 0;
+#if defined(GIT_HEATMAP_SSE2)
+    for (; i + 4 <= n; i += 4) {
+        auto* p = reinterpret_cast<__m128i*>(into + i);
+        _mm_storeu_si128(
+            p, _mm_add_epi32(_mm_loadu_si128(p),
+                             _mm_loadu_si128(
+                                 reinterpret_cast<const __m128i*>(from + i))));
+    }
+#elif defined(GIT_HEATMAP_NEON)
+    for (; i + 4 <= n; i += 4) {
+        vst1q_s32(into + i,
+                  vaddq_s32(vld1q_s32(into + i), vld1q_s32(from + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        into[i] += from[i];
+    }
+}
+
+std::int64_t sum_counts(int const* counts, std::size_t n) {
+    std::int64_t ret = 0;
+    std::size_t i = 0;
+    // Lanes hold 32-bit partial sums, so they are flushed into the 64-bit
+    // total every block.
+    constexpr std::size_t BLOCK = 256;
+#if defined(GIT_HEATMAP_SSE2)
+    while (i + 4 <= n) {
+        __m128i acc = _mm_setzero_si128();
+        for (auto end = std::min(n & ~std::size_t{3}, i + BLOCK); i < end;
+             i += 4) {
+            acc = _mm_add_epi32(
+                acc,
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + i)));
+        }
+        alignas(16) int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        ret += std::int64_t{lanes[0]} + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(GIT_HEATMAP_NEON)
+    while (i + 4 <= n) {
+        int32x4_t acc = vdupq_n_s32(0);
+        for (auto end = std::min(n & ~std::size_t{3}, i + BLOCK); i < end;
+             i += 4) {
+            acc = vaddq_s32(acc, vld1q_s32(counts + i));
+        }
+        ret += std::int64_t{vgetq_lane_s32(acc, 0)} + vgetq_lane_s32(acc, 1) +
+               vgetq_lane_s32(acc, 2) + vgetq_lane_s32(acc, 3);
+    }
+#endif
+    for (; i < n; i++) {
+        ret += counts[i];
+    }
+    return ret;
+}
+
+void quantize_levels(int const* counts, std::size_t n, std::uint8_t* levels) {
+    // The level is the number of thresholds a counter exceeds; every
+    // compare yields -1 per lane where it does.
+    std::size_t i = 0;
+#if defined(GIT_HEATMAP_SSE2)
+    const __m128i t0 = _mm_set1_epi32(0);
+    const __m128i t1 = _mm_set1_epi32(2);
+    const __m128i t2 = _mm_set1_epi32(5);
+    const __m128i t3 = _mm_set1_epi32(10);
+    auto level = [&](std::size_t at) {
+        __m128i c =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + at));
+        __m128i l =
+            _mm_add_epi32(_mm_cmpgt_epi32(c, t0), _mm_cmpgt_epi32(c, t1));
+        l = _mm_add_epi32(l, _mm_cmpgt_epi32(c, t2));
+        l = _mm_add_epi32(l, _mm_cmpgt_epi32(c, t3));
+        return _mm_sub_epi32(_mm_setzero_si128(), l);
+    };
+    for (; i + 16 <= n; i += 16) {
+        __m128i lo = _mm_packs_epi32(level(i), level(i + 4));
+        __m128i hi = _mm_packs_epi32(level(i + 8), level(i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(levels + i),
+                         _mm_packus_epi16(lo, hi));
+    }
+#elif defined(GIT_HEATMAP_NEON)
+    auto above = [](int32x4_t c, int threshold) {
+        return vreinterpretq_s32_u32(vcgtq_s32(c, vdupq_n_s32(threshold)));
+    };
+    auto level = [&](std::size_t at) {
+        int32x4_t c = vld1q_s32(counts + at);
+        int32x4_t l = vaddq_s32(above(c, 0), above(c, 2));
+        l = vaddq_s32(l, above(c, 5));
+        l = vaddq_s32(l, above(c, 10));
+        return vnegq_s32(l);
+    };
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t l =
+            vcombine_s16(vmovn_s32(level(i)), vmovn_s32(level(i + 4)));
+        vst1_u8(levels + i, vreinterpret_u8_s8(vmovn_s16(l)));
+    }
+#endif
+    for (; i < n; i++) {
+        auto c = counts[i];
+        levels[i] = static_cast<std::uint8_t>((c > 0) + (c > 2) + (c > 5) +
+                                              (c > 10));
+    }
+}
+
+Resolution rollup_resolution(std::string const& name) {
+    if (name == "day") {
+        return Resolution::DAY;
+    }
+    if (name == "week") {
+        return Resolution::WEEK;
+    }
+    if (name == "month") {
+        return Resolution::MONTH;
+    }
+    if (name == "year") {
+        return Resolution::YEAR;
+    }
+    throw std::invalid_argument("Unknown resolution: " + name);
+}
+
+Rollup::Rollup(std::chrono::sys_days start, std::vector<int> const& counts)
+    : start_{start}, prefix_(counts.size() + 1, 0) {
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        prefix_[i + 1] = prefix_[i] + counts[i];
+    }
+}
+
+std::int64_t Rollup::sum(std::size_t first, std::size_t last) const {
+    last = std::min(last, size());
+    if (first >= last) {
+        return 0;
+    }
+    return prefix_[last] - prefix_[first];
+}
+
+std::int64_t Rollup::sum(std::chrono::sys_days first,
+                         std::chrono::sys_days last) const {
+    auto from = std::max<std::int64_t>((first - start_).count(), 0);
+    auto to = std::max<std::int64_t>((last - start_).count() + 1, 0);
+    return sum(static_cast<std::size_t>(from), static_cast<std::size_t>(to));
+}
+
+std::vector<Bucket> Rollup::buckets(Resolution resolution) const {
+    using namespace std::chrono;
+    auto floor = [resolution](sys_days d) {
+        year_month_day ymd{d};
+        switch (resolution) {
+            case Resolution::WEEK:
+                return d - days(weekday{d}.iso_encoding() - 1);
+            case Resolution::MONTH:
+                return sys_days{ymd.year() / ymd.month() / 1};
+            case Resolution::YEAR:
+                return sys_days{ymd.year() / January / 1};
+            default:
+                return d;
+        }
+    };
+    auto next = [resolution](sys_days d) {
+        year_month_day ymd{d};
+        switch (resolution) {
+            case Resolution::WEEK:
+                return d + days(7);
+            case Resolution::MONTH:
+                return sys_days{(ymd.year() / ymd.month() + months(1)) / 1};
+            case Resolution::YEAR:
+                return sys_days{(ymd.year() + years(1)) / January / 1};
+            default:
+                return d + days(1);
+        }
+    };
+
+    std::vector<Bucket> ret;
+    if (size() == 0) {
+        return ret;
+    }
+    auto end = start_ + days(size());
+    for (auto b = floor(start_); b < end; b = next(b)) {
+        ret.push_back({b, sum(b, next(b) - days(1))});
+    }
+    return ret;
+}
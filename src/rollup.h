@@ -0,0 +1,63 @@
+#ifndef __GIT_HEATMAP_ROLLUP_H__
+#define __GIT_HEATMAP_ROLLUP_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "counts.h"
+
+// Bulk kernels over day counters, 4 (SSE2, NEON) counters at a time where
+// available.
+
+// into[i] += from[i] for n counters.
+void add_counts(int* into, int const* from, std::size_t n);
+// The sum of n counters.
+std::int64_t sum_counts(int const* counts, std::size_t n);
+// Heatmap level of every counter, as CommitNumberLevel values: 0, 1~2,
+// 3~5, 6~10 and more than 10 commits.
+void quantize_levels(int const* counts, std::size_t n, std::uint8_t* levels);
+
+enum class Resolution { DAY, WEEK, MONTH, YEAR };
+
+// "day", "week", "month" or "year".
+Resolution rollup_resolution(std::string const& name);
+
+struct Bucket {
+    // First calendar day of the bucket, which may lie before the series.
+    std::chrono::sys_days start;
+    std::int64_t count;
+};
+
+// Prefix sums over one day series: any range total is O(1), and weekly,
+// monthly or yearly aggregates cost one subtraction per bucket instead of
+// a pass over the days.
+class Rollup {
+   public:
+    Rollup(std::chrono::sys_days start, std::vector<int> const& counts);
+    explicit Rollup(DayCounts const& counts)
+        : Rollup(counts.start_days, counts.counts) {}
+
+    std::size_t size() const { return prefix_.size() - 1; }
+    std::chrono::sys_days start() const { return start_; }
+    std::int64_t total() const { return prefix_.back(); }
+
+    // Commits of the day indices [first, last), clamped to the series.
+    std::int64_t sum(std::size_t first, std::size_t last) const;
+    // Commits of the calendar days [first, last], clamped to the series.
+    std::int64_t sum(std::chrono::sys_days first,
+                     std::chrono::sys_days last) const;
+
+    // One bucket per calendar week (Monday first), month or year that
+    // overlaps the series, oldest first. Buckets at the edges only count
+    // the days inside the series.
+    std::vector<Bucket> buckets(Resolution resolution) const;
+
+   private:
+    std::chrono::sys_days start_;
+    std::vector<std::int64_t> prefix_;
+};
+
+#endif  // __GIT_HEATMAP_ROLLUP_H__
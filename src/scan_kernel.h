@@ -0,0 +1,156 @@
+#ifndef __GIT_HEATMAP_SCAN_KERNEL_H__
+#define __GIT_HEATMAP_SCAN_KERNEL_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <git2.h>
+
+#include "counts.h"
+#include "debug.h"
+#include "identity.h"
+#include "trailers.h"
+#include "utils.h"
+
+// The per-commit work of a scan, built from policies so that the options
+// are dispatched once per scan and every kernel only holds the work it
+// needs. A new option adds a policy rather than a branch per commit.
+//
+// Filter  static bool match(git_commit*, IdentityCache&, who, credit):
+//         whether a commit in the window counts; calls credit(id) for
+//         its matching identities when the buckets use them.
+// Metric  static int weight(git_commit*): what a matching commit adds.
+// Buckets static void credit(DayCounts&, IdentityCache&, id, day,
+//         weight): the breakdown series, on top of the per-day totals;
+//         static constexpr bool per_identity: whether credit does work.
+
+// Matches on the author alone.
+struct AuthorFilter {
+    template <typename Credit>
+    static bool match(git_commit*, IdentityCache& identities,
+                      std::uint32_t who, Credit&& credit) {
+        if (!identities[who].matched) {
+            return false;
+        }
+        credit(who);
+        return true;
+    }
+};
+
+// Matches on the author or a Co-authored-by trailer. Trailers are only
+// read when they can still change the counts.
+template <bool PerIdentity>
+struct CoauthorFilter {
+    template <typename Credit>
+    static bool match(git_commit* commit, IdentityCache& identities,
+                      std::uint32_t who, Credit&& credit) {
+        bool matched = identities[who].matched;
+        if (matched) {
+            credit(who);
+            if constexpr (!PerIdentity) {
+                return true;
+            }
+        }
+        for_each_coauthor(
+            git_commit_message(commit), [&](std::string_view coauthor) {
+                auto id = identities.id({}, coauthor);
+                if (id == who || !identities[id].matched) {
+                    return;
+                }
+                credit(id);
+                matched = true;
+            });
+        return matched;
+    }
+};
+
+// Every matching commit counts one.
+struct CommitCount {
+    static int weight(git_commit*) { return 1; }
+};
+
+// Per-day totals only.
+struct DayBuckets {
+    static constexpr bool per_identity = false;
+    static void credit(DayCounts&, IdentityCache&, std::uint32_t,
+                       std::int64_t, int) {}
+};
+
+// Also one series per matching identity in DayCounts::authors. Every
+// matching identity of a commit is credited, the totals count it once.
+struct AuthorBuckets {
+    static constexpr bool per_identity = true;
+    static void credit(DayCounts& counts, IdentityCache& identities,
+                       std::uint32_t id, std::int64_t day, int weight) {
+        auto& identity = identities[id];
+        if (identity.series == IdentityCache::NO_SERIES) {
+            identity.series = counts.authors.size();
+            counts.authors.push_back(
+                {identity.email, std::vector<int>(counts.size(), 0)});
+        }
+        counts.authors[identity.series].counts[day] += weight;
+    }
+};
+
+// One walk worker's counts and identity cache.
+struct ScanTally {
+    DayCounts counts;
+    IdentityCache identities;
+};
+
+// Counts the commits the walk visits into the tally of the visiting
+// worker. With Trace, commits left out are logged.
+template <typename Filter, typename Metric, typename Buckets, bool Trace>
+class ScanKernel {
+   public:
+    ScanKernel(std::vector<ScanTally>& tallies, std::int64_t first_day,
+               std::uint64_t days)
+        : tallies_{tallies}, first_day_{first_day}, days_{days} {}
+
+    void operator()(std::size_t worker, git_commit* commit) const {
+        auto& counts = tallies_[worker].counts;
+        auto& identities = tallies_[worker].identities;
+        auto local = local_time(git_commit_time(commit),
+                                git_commit_time_offset(commit));
+        auto day = local.day - first_day_;
+        bool in_window = static_cast<std::uint64_t>(day) < days_;
+        if constexpr (!Trace) {
+            if (!in_window) {
+                return;
+            }
+        }
+        auto const* author = git_commit_author(commit);
+        auto const who = identities.id(author->name, author->email);
+        auto weight = Metric::weight(commit);
+
+        bool matched =
+            in_window &&
+            Filter::match(commit, identities, who, [&](std::uint32_t id) {
+                if constexpr (Buckets::per_identity) {
+                    Buckets::credit(counts, identities, id, day, weight);
+                }
+            });
+        if (matched) {
+            counts.counts[day] += weight;
+            counts.punchcard[local.weekday][local.hour] += weight;
+        } else if constexpr (Trace) {
+            char sha1[GIT_OID_HEXSZ + 1] = {0};
+            git_oid_fmt(sha1, git_commit_id(commit));
+            DEBUG_LOG("Skipping commit at time: "
+                      << format_date(std::chrono::sys_days(
+                             std::chrono::days(local.day)))
+                      << " by " << identities[who].email
+                      << " sha1: " << sha1);
+        }
+    }
+
+   private:
+    std::vector<ScanTally>& tallies_;
+    std::int64_t first_day_;
+    std::uint64_t days_;
+};
+
+#endif  // __GIT_HEATMAP_SCAN_KERNEL_H__
@@ -0,0 +1,141 @@
+#include "scanner.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "debug.h"
+#include "glob.h"
+#include "identity.h"
+#include "scan_kernel.h"
+#include "utils.h"
+#include "walk.h"
+
+Scanner::Scanner(ScanOptions options) : options_{std::move(options)} {}
+
+DayCounts Scanner::scan(Repository& repository) const {
+    return scan(repository, repository.resolve(options_.branch));
+}
+
+DayCounts Scanner::scan(Repository& repository, git_oid const& tip) const {
+    return scan(repository, std::vector<git_oid>{tip});
+}
+
+DayCounts Scanner::scan(Repository& repository,
+                        std::vector<git_oid> const& tips) const {
+    auto const start_days = options_.start_days;
+    auto const end_days = options_.end_days;
+
+    DEBUG_LOG("today: " << today());
+    DEBUG_LOG("monday: " << monday());
+    DEBUG_LOG("sunday: " << sunday());
+    DEBUG_LOG("start date: " << start_days);
+    DEBUG_LOG("end date: " << end_days);
+    DEBUG_LOG("branch: " << options_.branch);
+
+    DayCounts result{start_days, end_days};
+    assert((result.size() % 7) == 0);
+    auto const days = static_cast<std::uint64_t>(result.size());
+
+    auto email_pattern = options_.email_pattern;
+    if (email_pattern.empty()) {
+        email_pattern = repository.default_email();
+    }
+    EmailMatcher email_matcher{email_pattern};
+    result.author = email_pattern;
+    DEBUG_LOG("author: " << email_pattern);
+
+    auto graph = repository.commit_graph();
+
+    // The walk filters on UTC commit time; widen the local-day window by
+    // the largest time zone offsets and let the day check below decide.
+    constexpr std::int64_t SECONDS_PER_DAY = 24 * 60 * 60;
+    constexpr std::int64_t MAX_OFFSET = 14 * 60 * 60;
+    auto const first_day = start_days.time_since_epoch().count();
+    WalkOptions walk_options;
+    walk_options.first_parent = options_.first_parent;
+    walk_options.no_merges = options_.no_merges;
+    walk_options.since = first_day * SECONDS_PER_DAY - MAX_OFFSET;
+    walk_options.until =
+        (end_days.time_since_epoch().count() + 1) * SECONDS_PER_DAY +
+        MAX_OFFSET;
+    std::shared_ptr<PackIndex const> packs;
+    if (options_.prefetch_depth > 0 && graph) {
+        packs = repository.pack_index();
+        walk_options.packs = packs.get();
+        walk_options.prefetch_depth = options_.prefetch_depth;
+    }
+
+    std::optional<Mailmap> mailmap;
+    if (options_.use_mailmap) {
+        mailmap.emplace(repository.acquire().get(), options_.mailmap_file);
+    }
+
+    // Every walk worker counts into its own tally; they are merged below.
+    auto threads = options_.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<ScanTally> tallies;
+    tallies.reserve(threads);
+    for (std::size_t i = 0; i < threads; i++) {
+        tallies.push_back({DayCounts{start_days, end_days},
+                           IdentityCache{mailmap ? &*mailmap : nullptr,
+                                         email_matcher}});
+    }
+
+    // The options pick the kernel here, once, instead of per commit.
+    auto walk = [&](auto filter, auto buckets, auto trace) {
+        using Kernel = ScanKernel<typename decltype(filter)::type, CommitCount,
+                                  typename decltype(buckets)::type,
+                                  decltype(trace)::value>;
+        walk_history_parallel(repository, graph.get(), tips, walk_options,
+                              threads, Kernel{tallies, first_day, days});
+    };
+    auto with_trace = [&](auto filter, auto buckets) {
+        if (debug_enabled()) {
+            walk(filter, buckets, std::true_type{});
+        } else {
+            walk(filter, buckets, std::false_type{});
+        }
+    };
+    auto with_filter = [&](auto buckets) {
+        constexpr bool per_identity = decltype(buckets)::type::per_identity;
+        if (options_.include_coauthors) {
+            with_trace(std::type_identity<CoauthorFilter<per_identity>>{},
+                       buckets);
+        } else {
+            with_trace(std::type_identity<AuthorFilter>{}, buckets);
+        }
+    };
+    if (options_.by_author) {
+        with_filter(std::type_identity<AuthorBuckets>{});
+    } else {
+        with_filter(std::type_identity<DayBuckets>{});
+    }
+    if (packs) {
+        auto stats = packs->stats();
+        DEBUG_LOG("prefetch: " << stats.requested << " requested, "
+                               << stats.hits << " hits, " << stats.misses
+                               << " misses, " << stats.unpacked
+                               << " not packed");
+    }
+
+    for (auto& tally : tallies) {
+        result.merge(tally.counts);
+    }
+    if (threads > 1) {
+        // Workers meet authors in no fixed order.
+        std::sort(result.authors.begin(), result.authors.end(),
+                  [](DaySeries const& a, DaySeries const& b) {
+                      return a.name < b.name;
+                  });
+    }
+    return result;
+}
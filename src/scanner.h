@@ -0,0 +1,58 @@
+#ifndef __GIT_HEATMAP_SCANNER_H__
+#define __GIT_HEATMAP_SCANNER_H__
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "counts.h"
+#include "repository.h"
+
+struct ScanOptions {
+    std::string branch{"HEAD"};
+    // Empty means the repository's user.email.
+    std::string email_pattern{};
+    std::chrono::sys_days start_days{std::chrono::days::zero()};
+    std::chrono::sys_days end_days{std::chrono::days::zero()};
+    // Also count per matching author email into DayCounts::authors.
+    bool by_author{false};
+    // Also credit matching emails of Co-authored-by trailers.
+    bool include_coauthors{false};
+    // Follow only the first parent of merges, as `git log --first-parent`.
+    bool first_parent{false};
+    // Skip merge commits, as `git log --no-merges`.
+    bool no_merges{false};
+    // Resolve identities through the repository's mailmap before matching.
+    bool use_mailmap{true};
+    // An extra mailmap file, applied over the repository's.
+    std::string mailmap_file{};
+    // Threads walking the history of one scan, 0 for one per core. Only
+    // used with a commit-graph that has corrected commit dates.
+    std::size_t threads{1};
+    // Commits whose pack reads are started ahead of their lookup, 0 for
+    // none. Needs a commit-graph to know the commits ahead.
+    std::size_t prefetch_depth{0};
+};
+
+// Walks the history of one branch and counts the matching commits per day.
+// A Scanner holds no mutable state, so one instance may serve concurrent
+// scans as long as each thread passes its own or a shared Repository.
+class Scanner {
+   public:
+    explicit Scanner(ScanOptions options);
+
+    DayCounts scan(Repository& repository) const;
+    // Scan from already resolved tips, ignoring options().branch. Several
+    // tips are walked as one history, so shared commits count once.
+    DayCounts scan(Repository& repository, git_oid const& tip) const;
+    DayCounts scan(Repository& repository,
+                   std::vector<git_oid> const& tips) const;
+
+    ScanOptions const& options() const { return options_; }
+
+   private:
+    ScanOptions options_;
+};
+
+#endif  // __GIT_HEATMAP_SCANNER_H__
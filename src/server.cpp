@@ -0,0 +1,552 @@
+#include "server.h"
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "debug.h"
+#include "exporter.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace {
+
+// Just enough JSON for the flat request and reply objects of the protocol:
+// string, number and literal values plus (nested) arrays of integers.
+struct JsonField {
+    std::string text;
+    std::vector<long long> numbers;
+};
+using JsonObject = std::map<std::string, JsonField>;
+
+class JsonReader {
+   public:
+    explicit JsonReader(std::string_view s) : s_{s} {}
+
+    JsonObject object() {
+        JsonObject ret;
+        expect('{');
+        if (peek() == '}') {
+            ++pos_;
+            return ret;
+        }
+        for (;;) {
+            auto key = string();
+            expect(':');
+            ret[key] = value();
+            if (peek() == ',') {
+                ++pos_;
+                continue;
+            }
+            expect('}');
+            return ret;
+        }
+    }
+
+   private:
+    char peek() {
+        while (pos_ < s_.size() &&
+               (s_[pos_] == ' ' || s_[pos_] == '\t' || s_[pos_] == '\r' ||
+                s_[pos_] == '\n')) {
+            ++pos_;
+        }
+        return pos_ < s_.size() ? s_[pos_] : '\0';
+    }
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::invalid_argument(std::string("malformed request: ") +
+                                        "expected '" + c + "'");
+        }
+        ++pos_;
+    }
+    std::string string() {
+        expect('"');
+        std::string ret;
+        while (pos_ < s_.size() && s_[pos_] != '"') {
+            char c = s_[pos_++];
+            if (c == '\\' && pos_ < s_.size()) {
+                c = s_[pos_++];
+                switch (c) {
+                    case 'n':
+                        c = '\n';
+                        break;
+                    case 't':
+                        c = '\t';
+                        break;
+                    case 'r':
+                        c = '\r';
+                        break;
+                    case 'b':
+                        c = '\b';
+                        break;
+                    case 'f':
+                        c = '\f';
+                        break;
+                    case 'u':
+                        // Only ASCII escapes are needed by the protocol.
+                        if (pos_ + 4 > s_.size()) {
+                            throw std::invalid_argument("malformed request");
+                        }
+                        c = static_cast<char>(
+                            std::stoi(std::string(s_.substr(pos_, 4)), 0, 16));
+                        pos_ += 4;
+                        break;
+                    default:
+                        break;
+                }
+            }
+            ret.push_back(c);
+        }
+        expect('"');
+        return ret;
+    }
+    JsonField value() {
+        JsonField ret;
+        auto c = peek();
+        if (c == '"') {
+            ret.text = string();
+        } else if (c == '[') {
+            array(ret.numbers);
+        } else {
+            auto begin = pos_;
+            while (pos_ < s_.size() && s_[pos_] != ',' && s_[pos_] != '}' &&
+                   s_[pos_] != ' ') {
+                ++pos_;
+            }
+            ret.text = std::string(s_.substr(begin, pos_ - begin));
+        }
+        return ret;
+    }
+
+    // Nested arrays are flattened in order.
+    void array(std::vector<long long>& numbers) {
+        expect('[');
+        while (peek() != ']') {
+            if (peek() == '[') {
+                array(numbers);
+            } else {
+                long long n = 0;
+                auto [ptr, ec] =
+                    std::from_chars(s_.data() + pos_, s_.data() + s_.size(), n);
+                if (ec != std::errc()) {
+                    throw std::invalid_argument("malformed request");
+                }
+                pos_ = ptr - s_.data();
+                numbers.push_back(n);
+            }
+            if (peek() == ',') {
+                ++pos_;
+            }
+        }
+        ++pos_;
+    }
+
+   private:
+    std::string_view s_;
+    std::size_t pos_{0};
+};
+
+std::string json_string(std::string const& s) {
+    std::string ret = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':
+                ret += "\\\"";
+                break;
+            case '\\':
+                ret += "\\\\";
+                break;
+            case '\n':
+                ret += "\\n";
+                break;
+            case '\t':
+                ret += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    ret += buf;
+                } else {
+                    ret.push_back(c);
+                }
+        }
+    }
+    ret += "\"";
+    return ret;
+}
+
+void put_u32(std::string& out, std::uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+std::string encode(DayCounts const& counts, bool binary) {
+    std::string ret;
+    Exporter{binary ? ExportFormat::BINARY : ExportFormat::JSON, &ret}.display(
+        counts);
+    return ret;
+}
+
+std::string encode_error(std::string const& message, bool binary) {
+    if (binary) {
+        std::string ret = "GHME";
+        put_u32(ret, static_cast<std::uint32_t>(message.size()));
+        return ret + message;
+    }
+    return "{\"error\": " + json_string(message) + "}\n";
+}
+
+std::chrono::sys_days date_field(JsonObject const& request, const char* name,
+                                 std::chrono::sys_days fallback) {
+    auto it = request.find(name);
+    if (it == request.end()) {
+        return fallback;
+    }
+    auto ret = parse_date(it->second.text);
+    if (!ret) {
+        throw std::invalid_argument(std::string("Invalid date format for ") +
+                                    name + ". Use YYYY-MM-DD");
+    }
+    return *ret;
+}
+
+HeatmapRequest make_request(JsonObject const& object) {
+    HeatmapRequest ret;
+    if (auto it = object.find("repo"); it != object.end()) {
+        ret.repo = it->second.text;
+    }
+    if (auto it = object.find("branch"); it != object.end()) {
+        ret.branch = it->second.text;
+    }
+    if (auto it = object.find("author"); it != object.end()) {
+        ret.author = it->second.text;
+    }
+    int weeks = MAX_DISPLAY_WEEKS;
+    if (auto it = object.find("weeks"); it != object.end()) {
+        weeks = std::stoi(it->second.text);
+        if (weeks <= 0) {
+            throw std::invalid_argument("weeks must be positive");
+        }
+    }
+    ret.end_days = date_field(object, "until", sunday());
+    ret.start_days = date_field(
+        object, "since", ret.end_days - std::chrono::days(weeks * 7 - 1));
+    return ret;
+}
+
+#ifndef _WIN32
+// Longest request line accepted; a client sending more without a newline
+// is disconnected.
+constexpr std::size_t MAX_REQUEST = 64 * 1024;
+
+std::atomic<bool> stop_requested{false};
+
+void request_stop(int) { stop_requested = true; }
+
+bool write_all(int fd, std::string_view data) {
+    while (!data.empty()) {
+        auto n = ::write(fd, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+sockaddr_un socket_address(std::string const& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("socket path too long: " + path);
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+#endif
+
+}  // namespace
+
+Server::Server(ServerOptions options)
+    : options_{std::move(options)}, service_{options_.cache_size} {}
+
+std::string Server::answer(std::string const& line) {
+    bool binary = false;
+    try {
+        auto object = JsonReader{line}.object();
+        if (auto it = object.find("format"); it != object.end()) {
+            if (it->second.text == "binary") {
+                binary = true;
+            } else if (it->second.text != "json") {
+                throw std::invalid_argument("unknown format: " +
+                                            it->second.text);
+            }
+        }
+        if (auto it = object.find("command"); it != object.end()) {
+            if (it->second.text != "stats") {
+                throw std::invalid_argument("unknown command: " +
+                                            it->second.text);
+            }
+            auto stats = service_.stats();
+            return "{\"hits\": " + std::to_string(stats.hits) +
+                   ", \"misses\": " + std::to_string(stats.misses) +
+                   ", \"coalesced\": " + std::to_string(stats.coalesced) +
+                   "}\n";
+        }
+        auto counts = service_.query(make_request(object));
+        return encode(counts, binary);
+    } catch (std::exception const& e) {
+        DEBUG_LOG("request failed: " << e.what());
+        return encode_error(e.what(), binary);
+    }
+}
+
+#ifndef _WIN32
+
+void Server::run() {
+    auto addr = socket_address(options_.socket_path);
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+    ::unlink(options_.socket_path.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) !=
+            0 ||
+        ::listen(listener, SOMAXCONN) != 0) {
+        ::close(listener);
+        throw std::runtime_error("Failed to listen on " +
+                                 options_.socket_path);
+    }
+    // Workers wake the polling thread through this pipe when they answered.
+    int wake[2];
+    if (::pipe(wake) != 0) {
+        ::close(listener);
+        throw std::runtime_error("Failed to create pipe");
+    }
+    for (int fd : wake) {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    // Connections are polled here and only a complete request line takes a
+    // pool thread, so idle clients hold none. A connection has at most one
+    // request in flight; it is not read from until it is answered, which
+    // keeps its replies in order.
+    struct Connection {
+        std::string pending;
+        bool busy{false};
+    };
+    std::map<int, Connection> connections;
+    std::mutex answered_mutex;
+    std::vector<std::pair<int, bool>> answered;
+
+    auto close_connection = [&connections](int fd) {
+        ::close(fd);
+        connections.erase(fd);
+    };
+    {
+        ThreadPool pool{options_.threads};
+        DEBUG_LOG("serving on " << options_.socket_path << " with "
+                                << pool.size() << " threads");
+
+        // Hands the next complete line of an idle connection to the pool;
+        // false when the connection is to be closed.
+        auto dispatch = [&](int fd, Connection& connection) {
+            while (!connection.busy) {
+                auto newline = connection.pending.find('\n');
+                if (newline == std::string::npos) {
+                    return connection.pending.size() <= MAX_REQUEST;
+                }
+                auto line = connection.pending.substr(0, newline);
+                connection.pending.erase(0, newline + 1);
+                if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                    continue;
+                }
+                connection.busy = true;
+                pool.submit([this, fd, line = std::move(line), &answered,
+                             &answered_mutex, wake_fd = wake[1]] {
+                    bool ok = write_all(fd, answer(line));
+                    {
+                        std::lock_guard<std::mutex> lock(answered_mutex);
+                        answered.emplace_back(fd, ok);
+                    }
+                    char c = 0;
+                    [[maybe_unused]] auto n = ::write(wake_fd, &c, 1);
+                });
+            }
+            return true;
+        };
+
+        std::vector<pollfd> fds;
+        std::vector<std::pair<int, bool>> done;
+        while (!stop_requested) {
+            fds.assign({{listener, POLLIN, 0}, {wake[0], POLLIN, 0}});
+            for (auto const& [fd, connection] : connections) {
+                if (!connection.busy) {
+                    fds.push_back({fd, POLLIN, 0});
+                }
+            }
+            if (::poll(fds.data(), fds.size(), 200) <= 0) {
+                continue;
+            }
+
+            if (fds[1].revents != 0) {
+                char buf[256];
+                while (::read(wake[0], buf, sizeof(buf)) > 0) {
+                }
+                {
+                    std::lock_guard<std::mutex> lock(answered_mutex);
+                    done.swap(answered);
+                }
+                for (auto [fd, ok] : done) {
+                    auto& connection = connections[fd];
+                    connection.busy = false;
+                    if (!ok || !dispatch(fd, connection)) {
+                        close_connection(fd);
+                    }
+                }
+                done.clear();
+            }
+
+            for (std::size_t i = 2; i < fds.size(); i++) {
+                if (fds[i].revents == 0) {
+                    continue;
+                }
+                auto fd = fds[i].fd;
+                char buf[4096];
+                auto n = ::read(fd, buf, sizeof(buf));
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    close_connection(fd);
+                    continue;
+                }
+                auto& connection = connections[fd];
+                connection.pending.append(buf, static_cast<std::size_t>(n));
+                if (!dispatch(fd, connection)) {
+                    DEBUG_LOG("closing connection sending an oversized "
+                              "request");
+                    close_connection(fd);
+                }
+            }
+
+            if (fds[0].revents != 0) {
+                int client = ::accept(listener, nullptr, nullptr);
+                if (client >= 0) {
+                    connections[client];
+                }
+            }
+        }
+        // Unblock workers still writing to slow clients, so that the pool
+        // can finish its queue and join.
+        for (auto const& [fd, connection] : connections) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+    for (auto const& [fd, connection] : connections) {
+        ::close(fd);
+    }
+    ::close(wake[0]);
+    ::close(wake[1]);
+    ::close(listener);
+    ::unlink(options_.socket_path.c_str());
+}
+
+DayCounts query_server(std::string const& socket_path,
+                       HeatmapRequest const& request) {
+    auto addr = socket_address(socket_path);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr),
+                            sizeof(addr)) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        throw std::runtime_error("Failed to connect to " + socket_path);
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto line = "{\"repo\": " + json_string(request.repo) +
+                ", \"branch\": " + json_string(request.branch) +
+                ", \"author\": " + json_string(request.author) +
+                ", \"since\": \"" + format_date(request.start_days) +
+                "\", \"until\": \"" + format_date(request.end_days) + "\"}\n";
+    std::string reply;
+    if (write_all(fd, line)) {
+        char buf[4096];
+        for (;;) {
+            auto n = ::read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            reply.append(buf, static_cast<std::size_t>(n));
+            if (reply.back() == '\n') {
+                break;
+            }
+        }
+    }
+    ::close(fd);
+
+    auto object = JsonReader{reply}.object();
+    if (auto it = object.find("error"); it != object.end()) {
+        throw std::runtime_error(it->second.text);
+    }
+    DayCounts ret{date_field(object, "start", request.start_days),
+                  date_field(object, "end", request.end_days)};
+    ret.author = object["author"].text;
+    auto const& counts = object["counts"].numbers;
+    if (counts.size() != ret.size()) {
+        throw std::runtime_error("malformed reply from " + socket_path);
+    }
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        ret.counts[i] = static_cast<int>(counts[i]);
+    }
+    auto const& punchcard = object["punchcard"].numbers;
+    if (punchcard.size() == 7 * 24) {
+        for (std::size_t i = 0; i < punchcard.size(); i++) {
+            ret.punchcard[i / 24][i % 24] = static_cast<int>(punchcard[i]);
+        }
+    }
+    return ret;
+}
+
+#else
+
+void Server::run() {
+    throw std::runtime_error("serve is not supported on Windows");
+}
+
+DayCounts query_server(std::string const&, HeatmapRequest const&) {
+    throw std::runtime_error("--socket is not supported on Windows");
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef __GIT_HEATMAP_SERVER_H__
+#define __GIT_HEATMAP_SERVER_H__
+
+#include <cstddef>
+#include <string>
+
+#include "counts.h"
+#include "service.h"
+
+// Newline delimited protocol over a Unix domain socket. Each request is a
+// flat JSON object on one line:
+//
+//     {"repo": "/path", "branch": "main", "author": "*@example.com",
+//      "since": "2025-01-01", "until": "2025-12-31", "format": "json"}
+//
+// "branch", "author", "since"/"until" (or "weeks", default 52, ending this
+// Sunday) and "format" are optional. A "json" reply is one line:
+//
+//     {"author": "...", "start": "YYYY-MM-DD", "end": "YYYY-MM-DD",
+//      "total": 42, "counts": [0, 1, ...]}
+//
+// which is the `--format json` export, or {"error": "..."}. A "binary"
+// reply is the `--format bin` export, whose header carries its size, or
+// the bytes "GHME", a little-endian u32 length and the error message.
+// {"command": "stats"} returns the cache counters.
+struct ServerOptions {
+    std::string socket_path;
+    std::size_t threads{0};
+    std::size_t cache_size{256};
+};
+
+class Server {
+   public:
+    explicit Server(ServerOptions options);
+
+    // Serve until SIGINT or SIGTERM.
+    void run();
+
+   private:
+    std::string answer(std::string const& line);
+
+   private:
+    ServerOptions options_;
+    HeatmapService service_;
+};
+
+// Client side of the protocol, used by `git-heatmap --socket`.
+DayCounts query_server(std::string const& socket_path,
+                       HeatmapRequest const& request);
+
+#endif  // __GIT_HEATMAP_SERVER_H__
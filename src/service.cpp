@@ -0,0 +1,100 @@
+#include "service.h"
+
+#include <filesystem>
+#include <stdexcept>
+
+#include "debug.h"
+#include "glob.h"
+#include "scanner.h"
+#include "utils.h"
+
+HeatmapService::HeatmapService(std::size_t cache_size,
+                               std::size_t open_repositories)
+    : repositories_{open_repositories}, cache_{cache_size} {}
+
+std::shared_ptr<Repository> HeatmapService::repository(
+    std::string const& path) {
+    std::error_code ec;
+    auto key = std::filesystem::weakly_canonical(path, ec).string();
+    if (ec) {
+        key = path;
+    }
+    std::lock_guard<std::mutex> lock(repositories_mutex_);
+    if (auto repo = repositories_.get(key)) {
+        return *repo;
+    }
+    auto repo = std::make_shared<Repository>(key);
+    repositories_.put(key, repo);
+    return repo;
+}
+
+DayCounts HeatmapService::query(HeatmapRequest const& request) {
+    if (request.repo.empty()) {
+        throw std::invalid_argument("missing repository path");
+    }
+    if (request.start_days > request.end_days) {
+        throw std::invalid_argument("empty date range");
+    }
+    if (!is_valid_glob_pattern(request.author)) {
+        throw std::invalid_argument("Invalid email pattern: " +
+                                    request.author);
+    }
+    auto handle = repository(request.repo);
+    auto& repo = *handle;
+    auto author = request.author.empty() ? repo.default_email()
+                                         : request.author;
+    auto tip = repo.resolve(request.branch);
+    auto start_days = monday(request.start_days);
+    auto end_days = sunday(request.end_days);
+
+    char sha1[GIT_OID_HEXSZ + 1] = {0};
+    git_oid_fmt(sha1, &tip);
+
+    std::string key = repo.git_dir();
+    key.append(1, '\0').append(sha1);
+    key.append(1, '\0').append(author);
+    key.append(1, '\0').append(format_date(start_days));
+    key.append(1, '\0').append(format_date(end_days));
+
+    std::promise<DayCounts> promise;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (auto hit = cache_.get(key)) {
+            stats_.hits++;
+            return *hit;
+        }
+        if (auto it = in_flight_.find(key); it != in_flight_.end()) {
+            stats_.coalesced++;
+            auto pending = it->second;
+            lock.unlock();
+            return pending.get();
+        }
+        stats_.misses++;
+        in_flight_.emplace(key, promise.get_future().share());
+    }
+
+    DEBUG_LOG("scanning " << repo.git_dir() << " at " << sha1 << " for "
+                          << author);
+    try {
+        Scanner scanner{{.branch = request.branch,
+                         .email_pattern = author,
+                         .start_days = start_days,
+                         .end_days = end_days}};
+        auto result = scanner.scan(repo, tip);
+        promise.set_value(result);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cache_.put(key, result);
+        in_flight_.erase(key);
+        return result;
+    } catch (...) {
+        promise.set_exception(std::current_exception());
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(key);
+        throw;
+    }
+}
+
+HeatmapService::Stats HeatmapService::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
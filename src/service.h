@@ -0,0 +1,59 @@
+#ifndef __GIT_HEATMAP_SERVICE_H__
+#define __GIT_HEATMAP_SERVICE_H__
+
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "counts.h"
+#include "lru_cache.h"
+#include "repository.h"
+
+struct HeatmapRequest {
+    std::string repo;
+    std::string branch{"HEAD"};
+    // Empty means the repository's user.email.
+    std::string author{};
+    std::chrono::sys_days start_days{std::chrono::days::zero()};
+    std::chrono::sys_days end_days{std::chrono::days::zero()};
+};
+
+// Answers heatmap queries for a resident process. Handles of the most
+// recently queried repositories stay open between queries, with their
+// commit-graph and pack mappings; results are kept in an LRU keyed by
+// (repository, tip oid, author pattern, range), and identical queries that
+// arrive while one is being scanned wait for that scan instead of starting
+// their own. Safe to call from any number of threads.
+class HeatmapService {
+   public:
+    struct Stats {
+        std::size_t hits{0};
+        std::size_t misses{0};
+        std::size_t coalesced{0};
+    };
+
+    explicit HeatmapService(std::size_t cache_size = 256,
+                            std::size_t open_repositories = 32);
+
+    DayCounts query(HeatmapRequest const& request);
+
+    Stats stats() const;
+
+   private:
+    // Shared with the queries using it, so that one evicted meanwhile is
+    // closed when the last of them returns.
+    std::shared_ptr<Repository> repository(std::string const& path);
+
+   private:
+    std::mutex repositories_mutex_;
+    LruCache<std::string, std::shared_ptr<Repository>> repositories_;
+    mutable std::mutex mutex_;
+    LruCache<std::string, DayCounts> cache_;
+    std::map<std::string, std::shared_future<DayCounts>> in_flight_;
+    Stats stats_;
+};
+
+#endif  // __GIT_HEATMAP_SERVICE_H__
@@ -0,0 +1,197 @@
+#include "submodules.h"
+
+#include <algorithm>
+#include <future>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "debug.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+static void collect_submodules(git_repository* repo, std::string const& prefix,
+                               std::vector<Submodule>& out) {
+    struct Context {
+        std::string const& prefix;
+        std::vector<Submodule>& out;
+    } context{prefix, out};
+
+    auto first = out.size();
+    git_submodule_foreach(
+        repo,
+        [](git_submodule* sm, const char*, void* payload) -> int {
+            auto& ctx = *static_cast<Context*>(payload);
+            auto const* commit = git_submodule_wd_id(sm);
+            if (commit == nullptr) {
+                commit = git_submodule_head_id(sm);
+            }
+            git_repository* sub{nullptr};
+            if (commit == nullptr || 0 != git_submodule_open(&sub, sm)) {
+                DEBUG_LOG("Skipping submodule that is not checked out: "
+                          << git_submodule_path(sm));
+                return 0;
+            }
+            git_repository_ptr guard{sub};
+            auto const* workdir = git_repository_workdir(sub);
+            auto const* url = git_submodule_url(sm);
+            ctx.out.push_back({ctx.prefix + git_submodule_path(sm),
+                               workdir ? workdir : git_repository_path(sub),
+                               git_repository_commondir(sub),
+                               url ? url : "", *commit});
+            return 0;
+        },
+        &context);
+
+    auto last = out.size();
+    for (auto i = first; i < last; i++) {
+        auto path = out[i].path + "/";
+        git_repository* sub{nullptr};
+        if (0 != git_repository_open(&sub, out[i].workdir.c_str())) {
+            continue;
+        }
+        git_repository_ptr guard{sub};
+        collect_submodules(sub, path, out);
+    }
+}
+
+std::vector<Submodule> list_submodules(Repository& repository) {
+    std::vector<Submodule> ret;
+    auto repo = repository.acquire();
+    collect_submodules(repo.get(), "", ret);
+    return ret;
+}
+
+std::vector<git_oid> worktree_heads(Repository& repository) {
+    std::vector<git_oid> ret;
+    auto repo = repository.acquire();
+    git_strarray names{nullptr, 0};
+    if (0 != git_worktree_list(&names, repo.get())) {
+        return ret;
+    }
+    for (std::size_t i = 0; i < names.count; i++) {
+        git_worktree* worktree{nullptr};
+        if (0 != git_worktree_lookup(&worktree, repo.get(),
+                                     names.strings[i])) {
+            continue;
+        }
+        git_repository* wt{nullptr};
+        git_oid head;
+        if (0 == git_worktree_validate(worktree) &&
+            0 == git_repository_open_from_worktree(&wt, worktree) &&
+            0 == git_reference_name_to_id(&head, wt, "HEAD")) {
+            ret.push_back(head);
+        }
+        git_repository_free(wt);
+        git_worktree_free(worktree);
+    }
+    git_strarray_dispose(&names);
+    return ret;
+}
+
+DayCounts scan_recursive(Scanner const& scanner, Repository& repository,
+                         RecursiveScanOptions const& options,
+                         std::vector<ScannedTip>* tips) {
+    // Resolve the author once so that every submodule matches the same
+    // pattern instead of its own user.email.
+    auto scan_options = scanner.options();
+    if (scan_options.email_pattern.empty()) {
+        scan_options.email_pattern = repository.default_email();
+    }
+    Scanner resolved{scan_options};
+
+    struct Target {
+        std::string name;
+        std::string path;
+        std::string id;
+        std::vector<git_oid> tips;
+    };
+    std::vector<Target> targets;
+    std::map<std::string, std::size_t> by_store;
+
+    auto add = [&](std::string const& name, std::string const& path,
+                   std::string const& store, std::string const& id,
+                   git_oid const& tip) {
+        auto [it, inserted] = by_store.try_emplace(store, targets.size());
+        if (inserted) {
+            targets.push_back({name, path, id, {}});
+        } else {
+            DEBUG_LOG(name << " shares the object store of "
+                           << targets[it->second].name);
+        }
+        targets[it->second].tips.push_back(tip);
+    };
+
+    add(".", repository.path(), repository.git_dir(), options.id,
+        repository.resolve(scan_options.branch));
+    if (options.worktrees) {
+        for (auto const& head : worktree_heads(repository)) {
+            add(".", repository.path(), repository.git_dir(), options.id,
+                head);
+        }
+    }
+    if (options.submodules) {
+        for (auto const& sm : list_submodules(repository)) {
+            // A relative URL is relative to the superproject's.
+            auto id = strip_userinfo(sm.url);
+            if (id.empty()) {
+                id = options.id + ":" + sm.path;
+            } else if (id.starts_with("./") || id.starts_with("../")) {
+                id = options.id + "/" + id;
+            }
+            add(sm.path, sm.workdir, sm.git_dir, id, sm.commit);
+        }
+    }
+
+    std::size_t jobs = options.jobs;
+    if (jobs == 0) {
+        jobs = std::thread::hardware_concurrency();
+    }
+    // Declared before the pool: when a result throws, the pool still runs
+    // the other tasks while it is destroyed, and they write `scanned`.
+    std::vector<std::future<DayCounts>> results;
+    // Written by the task of each target, read after its result.
+    std::vector<char> scanned(targets.size(), 1);
+    ThreadPool pool{std::min(jobs, targets.size())};
+    for (std::size_t i = 0; i < targets.size(); i++) {
+        results.push_back(pool.submit([&, i] {
+            if (i == 0) {
+                return resolved.scan(repository, targets[i].tips);
+            }
+            // A broken submodule must not fail the whole heatmap.
+            try {
+                Repository sub{targets[i].path};
+                return resolved.scan(sub, targets[i].tips);
+            } catch (std::exception const& e) {
+                DEBUG_LOG("Failed to scan " << targets[i].name << ": "
+                                            << e.what());
+                scanned[i] = 0;
+                return DayCounts{scan_options.start_days,
+                                 scan_options.end_days};
+            }
+        }));
+    }
+
+    DayCounts ret = results[0].get();
+    if (options.by_repo) {
+        ret.repos.push_back({targets[0].name, ret.counts});
+    }
+    for (std::size_t i = 1; i < results.size(); i++) {
+        auto counts = results[i].get();
+        if (options.by_repo) {
+            counts.repos.push_back({targets[i].name, counts.counts});
+        }
+        ret.merge(counts);
+    }
+    if (tips) {
+        for (std::size_t i = 0; i < targets.size(); i++) {
+            if (!scanned[i]) {
+                continue;
+            }
+            for (auto const& tip : targets[i].tips) {
+                tips->push_back({targets[i].id, tip});
+            }
+        }
+    }
+    return ret;
+}
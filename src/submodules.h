@@ -0,0 +1,48 @@
+#ifndef __GIT_HEATMAP_SUBMODULES_H__
+#define __GIT_HEATMAP_SUBMODULES_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "counts.h"
+#include "partial.h"
+#include "repository.h"
+#include "scanner.h"
+
+// A checked out submodule, at any depth below the superproject.
+struct Submodule {
+    std::string path;     // relative to the superproject work tree
+    std::string workdir;  // where it is checked out
+    std::string git_dir;  // its object store, shared by repeated instances
+    std::string url;      // as in .gitmodules, possibly relative
+    git_oid commit;       // the commit currently checked out
+};
+
+std::vector<Submodule> list_submodules(Repository& repository);
+
+// HEADs of the linked worktrees of a repository. They share its object
+// store, so they are walked as extra tips of the same scan.
+std::vector<git_oid> worktree_heads(Repository& repository);
+
+struct RecursiveScanOptions {
+    bool submodules{true};
+    bool worktrees{false};
+    // Fill DayCounts::repos with one series per scanned object store.
+    bool by_repo{false};
+    // Threads scanning side by side, 0 for one per core.
+    std::size_t jobs{0};
+    // The name of the superproject in the scanned tips. Submodules are
+    // named after their URL, relative ones below this name.
+    std::string id{};
+};
+
+// Scan the superproject and every checked out submodule on a bounded
+// thread pool and merge the results. Submodule instances sharing an object
+// store are scanned once, with all their commits as tips. When `tips` is
+// given, every tip of every store scanned successfully is appended to it.
+DayCounts scan_recursive(Scanner const& scanner, Repository& repository,
+                         RecursiveScanOptions const& options,
+                         std::vector<ScannedTip>* tips = nullptr);
+
+#endif  // __GIT_HEATMAP_SUBMODULES_H__
@@ -8,31 +8,19 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
-#include <map>
+#include <sstream>
+#include <stdexcept>
 
+#include "rollup.h"
 #include "utils.h"
 
 static std::vector<std::string> week_label{"Mon", "Tue", "Wed", "Thu",
                                            "Fri", "Sat", "Sun"};
 
-[[maybe_unused]] static CommitNumberLevel get_commit_number_level(int count) {
-    if (count == 0) {
-        return CommitNumberLevel::LEVEL0;
-    }
-    if (2 >= count) {
-        return CommitNumberLevel::LEVEL1;
-    }
-    if (5 >= count) {
-        return CommitNumberLevel::LEVEL2;
-    }
-    if (10 >= count) {
-        return CommitNumberLevel::LEVEL3;
-    }
-    return CommitNumberLevel::LEVEL4;
-}
-
 [[maybe_unused]] static int color_string_length(std::string const& str) {
     int len = 0;
 
@@ -73,45 +61,36 @@ static std::vector<std::string> week_label{"Mon", "Tue", "Wed", "Thu",
     return len;
 }
 
-ColorScheme::ColorScheme(std::string const& color)
-    : current_color(ColorScheme::default_schemes.at(color)) {}
-
-std::map<std::string, ColorScheme::Scheme> const ColorScheme::default_schemes =
-    {{"default", {"#333333", "#9be9a8", "#40c463", "#30a14e", "#216e39"}},
-     {"github", {"#ebedf0", "#9be9a8", "#40c463", "#30a14e", "#216e39"}},
-     {"vibrant", {"#333333", "#F9ED69", "#F08A5D", "#B83B5E", "#6A2C70"}},
-     {"blackwhite", {"#333333", "#707070", "#a0a0a0", "#d0d0d0", "#ffffff"}},
-     {"dracula", {"#282a36", "#50fa7b", "#ff79c6", "#bd93f9", "#6272a4"}},
-     {"north", {"#333333", "#DBE2EF", "#3282B8", "#3F72AF", "#112D4E"}},
-     {"gold", {"#333333", "#FDEEDC", "#FFD8A9", "#F1A661", "#E38B29"}},
-     {"sunset", {"#333333", "#F67280", "#C06C84", "#6C5B7B", "#355C7D"}},
-     {"mint", {"#333333", "#5AFEAD", "#21B475", "#1D794B", "#294B36"}}};
-
-const std::string ColorScheme::info = "\033[38;2;100;100;100m";
-const std::string ColorScheme::reset = "\033[0m";
-
-const std::map<std::string, std::pair<const char*, const char*>>
-    ColorScheme::blocks = {{"square", {"◼︎", "◼︎"}},  {"block", {"█", "█"}},
-                           {"dot", {"•", "•"}},     {"fisheye", {"◉", "●"}},
-                           {"diamond", {"♦︎", "♦︎"}}, {"plus", {"✚", "•"}}};
-
-// 将16进制颜色转换为ANSI转义序列
-static std::string rgb_color(const char* hex) {
-    unsigned int r, g, b;
-    sscanf(hex + 1, "%02x%02x%02x", &r, &g, &b);
-    return "\033[38;2;" + std::to_string(r) + ";" + std::to_string(g) + ";" +
-           std::to_string(b) + "m";
+ColorScheme::ColorScheme(std::string_view name)
+    : current_color(&ColorScheme::scheme(name)) {}
+
+ColorScheme::Scheme const& ColorScheme::scheme(std::string_view name) {
+    for (auto const& entry : default_schemes) {
+        if (entry.name == name) {
+            return entry.colors;
+        }
+    }
+    throw std::invalid_argument("Unknown color scheme: " + std::string(name));
 }
 
-std::string ColorScheme::level_color(CommitNumberLevel level) const {
-    return rgb_color(current_color[static_cast<int>(level)]);
+ColorScheme::Glyph const& ColorScheme::glyph(std::string_view name) {
+    for (auto const& entry : blocks) {
+        if (entry.name == name) {
+            return entry;
+        }
+    }
+    throw std::invalid_argument("Unknown glyph: " + std::string(name));
+}
+
+std::string_view ColorScheme::level_color(CommitNumberLevel level) const {
+    return (*current_color)[static_cast<int>(level)];
 }
 
 Terminal::Terminal(std::string const& color_scheme, std::string const& glyph,
-                   std::string const& author)
-    : author_{author},
-      color_scheme_(color_scheme),
-      glyph_{ColorScheme::blocks.at(glyph)} {}
+                   TerminalView view)
+    : color_scheme_(color_scheme),
+      glyph_{ColorScheme::glyph(glyph)},
+      view_{view} {}
 
 int Terminal::columns() const {
 #ifdef _WIN32
@@ -128,39 +107,35 @@ int Terminal::columns() const {
 #endif
     return 0;
 }
-std::string Terminal::info_color() const { return ColorScheme::info; }
-std::string Terminal::reset_color() const { return ColorScheme::reset; }
-std::string Terminal::level_color(CommitNumberLevel level) const {
+std::string_view Terminal::info_color() const { return ColorScheme::info; }
+std::string_view Terminal::reset_color() const { return ColorScheme::reset; }
+std::string_view Terminal::level_color(CommitNumberLevel level) const {
     return color_scheme_.level_color(level);
 }
 
-void Terminal::set_author(std::string const& author) { author_ = author; }
-
-static std::string make_month_lable(
-    std::vector<std::pair<const std::chrono::sys_days, int>> commits) {
+static std::string make_month_lable(DayCounts const& commits) {
     std::string month_lable(commits.size() / 7 * 2, ' ');
-    for (auto i = begin(commits); i < end(commits); i = i + 7) {
-        std::chrono::year_month_day s = i->first;
-        std::chrono::year_month_day e = (i + 6)->first;
+    for (std::size_t i = 0; i < commits.size(); i = i + 7) {
+        std::chrono::year_month_day s = commits.day(i);
+        std::chrono::year_month_day e = commits.day(i + 6);
         if (s.month() != e.month() ||
             1 == (static_cast<unsigned int>(s.day()))) {
             auto m = static_cast<unsigned int>(e.month());
             if (m >= 10) {
-                month_lable[(i - begin(commits)) / 7 * 2] = '1';
+                month_lable[i / 7 * 2] = '1';
             }
-            month_lable[(i - begin(commits)) / 7 * 2 + 1] = '0' + (m % 10);
+            month_lable[i / 7 * 2 + 1] = '0' + (m % 10);
         }
     }
     return month_lable;
 }
 
-static std::string make_footer_lable(
-    std::string const& email,
-    std::vector<std::pair<const std::chrono::sys_days, int>> commits,
-    ColorScheme const& color_scheme,
-    std::pair<const char*, const char*> glyph) {
+static std::string make_footer_lable(std::string const& email,
+                                     DayCounts const& commits,
+                                     ColorScheme const& color_scheme,
+    ColorScheme::Glyph const& glyph) {
     std::stringstream output;
-    auto [full, empty] = glyph;
+    auto [name, full, empty] = glyph;
     output << color_scheme.level_color(CommitNumberLevel::LEVEL0) << empty
            << color_scheme.reset << " 0 ";
     output << color_scheme.level_color(CommitNumberLevel::LEVEL1) << full
@@ -174,10 +149,7 @@ static std::string make_footer_lable(
 
     std::string footer_lable_right = output.str();
 
-    auto total = 0;
-    for (auto const& c : commits) {
-        total += c.second;
-    }
+    auto total = commits.total();
     std::string footer_lable_left =
         "Author: " + email + ", commits: " + std::to_string(total);
 
@@ -192,44 +164,46 @@ static std::string make_footer_lable(
     return footer_lable_left + spaces + footer_lable_right;
 }
 
-void Terminal::display(
-    std::vector<std::pair<const std::chrono::sys_days, int>> commits) {
+void Terminal::display(DayCounts const& commits) {
+    if (view_ == TerminalView::PUNCHCARD) {
+        display_punchcard(commits);
+    } else {
+        display_heatmap(commits);
+    }
+}
+
+void Terminal::display_heatmap(DayCounts const& commits) {
     assert((commits.size() % 7) == 0);
     assert((commits.size() / 7) == MAX_DISPLAY_WEEKS);
 
-    auto month_lable =
-        color_scheme_.info + make_month_lable(commits) + color_scheme_.reset;
-
     std::ostringstream output;
-    output << "   " << month_lable << "\n";
+    output << "   " << color_scheme_.info << make_month_lable(commits)
+           << color_scheme_.reset << "\n";
 
-    auto [full, empty] = glyph_;
+    auto [name, full, empty] = glyph_;
 
+    std::vector<std::uint8_t> levels(commits.size());
+    quantize_levels(commits.counts.data(), commits.size(), levels.data());
     for (int i = 0; i < 7; i++) {
         output << color_scheme_.info << week_label[i] << color_scheme_.reset;
         for (int j = 0; j < (int)commits.size() / 7; j++) {
-            auto c = commits.begin() + i + j * 7;
-            if (c->second > 0) {
-                output << " "
-                       << color_scheme_.level_color(
-                              get_commit_number_level(c->second))
-                       << full << color_scheme_.reset;
-            } else {
-                output << " "
-                       << color_scheme_.level_color(
-                              get_commit_number_level(c->second))
-                       << empty << color_scheme_.reset;
-            }
+            auto level = static_cast<CommitNumberLevel>(levels[i + j * 7]);
+            output << " " << color_scheme_.level_color(level)
+                   << (level != CommitNumberLevel::LEVEL0 ? full : empty)
+                   << color_scheme_.reset;
         }
         output << "\n";
     }
 
-    auto footer_lable =
-        color_scheme_.info +
-        make_footer_lable(author_, commits, color_scheme_, glyph_) +
-        color_scheme_.reset;
+    output << "   " << color_scheme_.info
+           << make_footer_lable(commits.author, commits, color_scheme_, glyph_)
+           << color_scheme_.reset << "\n";
 
-    output << "   " << footer_lable << "\n";
+    for (auto const& repo : commits.repos) {
+        output << "   " << color_scheme_.info << repo.name << ": "
+               << DayCounts::total(repo.counts) << color_scheme_.reset
+               << "\n";
+    }
 
     std::cout.flush();
     std::cout << output.str();
@@ -237,12 +211,56 @@ void Terminal::display(
     return;
 }
 
+// A punchcard sums a whole range into each cell, so the levels are
+// relative to the busiest hour instead of fixed commit numbers.
+static CommitNumberLevel get_relative_level(int count, int max) {
+    if (count == 0 || max == 0) {
+        return CommitNumberLevel::LEVEL0;
+    }
+    return static_cast<CommitNumberLevel>((count * 4 + max - 1) / max);
+}
+
+void Terminal::display_punchcard(DayCounts const& commits) {
+    auto [name, full, empty] = glyph_;
+    int max = 0;
+    for (auto const& hours : commits.punchcard) {
+        for (auto c : hours) {
+            max = std::max(max, c);
+        }
+    }
+
+    std::ostringstream output;
+    output << "   " << color_scheme_.info;
+    for (int hour = 0; hour < 24; hour++) {
+        output << (hour % 3 == 0 ? (hour < 10 ? " " : "") + std::to_string(hour)
+                                 : "  ");
+    }
+    output << color_scheme_.reset << "\n";
+
+    for (int i = 0; i < 7; i++) {
+        output << color_scheme_.info << week_label[i] << color_scheme_.reset;
+        for (auto c : commits.punchcard[i]) {
+            output << " "
+                   << color_scheme_.level_color(get_relative_level(c, max))
+                   << (c > 0 ? full : empty) << color_scheme_.reset;
+        }
+        output << "\n";
+    }
+
+    output << "   " << color_scheme_.info << "Author: " << commits.author
+           << ", commits: " << commits.total()
+           << ", busiest hour: " << max << color_scheme_.reset << "\n";
+
+    std::cout.flush();
+    std::cout << output.str();
+    std::cout.flush();
+}
+
 std::string Terminal::show_example(std::string const& color_scheme,
                                    std::string const& glyph) {
-    ColorScheme const& scheme{color_scheme};
-    auto block = ColorScheme::blocks.at(glyph);
+    ColorScheme const scheme{color_scheme};
+    auto [name, full, empty] = ColorScheme::glyph(glyph);
     std::stringstream output;
-    auto [full, empty] = block;
     output << scheme.level_color(CommitNumberLevel::LEVEL0) << empty
            << scheme.reset << " 0 ";
     output << scheme.level_color(CommitNumberLevel::LEVEL1) << full
@@ -259,10 +277,9 @@ std::string Terminal::show_example(std::string const& color_scheme,
 
 std::string Terminal::show_example2(std::string const& color_scheme,
                                     std::string const& glyph) {
-    ColorScheme const& scheme{color_scheme};
-    auto block = ColorScheme::blocks.at(glyph);
+    ColorScheme const scheme{color_scheme};
+    auto [name, full, empty] = ColorScheme::glyph(glyph);
     std::stringstream output;
-    auto [full, empty] = block;
     output << scheme.reset << " ";
     output << scheme.level_color(CommitNumberLevel::LEVEL0) << empty
            << scheme.reset << " ";
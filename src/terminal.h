@@ -3,8 +3,12 @@
 
 #include <array>
 #include <chrono>
-#include <map>
+#include <cstddef>
 #include <string>
+#include <string_view>
+
+#include "counts.h"
+#include "renderer.h"
 
 enum class CommitNumberLevel {
     LEVEL0 = 0, /* 0 */
@@ -14,35 +18,119 @@ enum class CommitNumberLevel {
     LEVEL4      /* 9~ */
 };
 
+// A 24-bit ANSI foreground escape sequence, built from "#rrggbb" at
+// compile time so that rendering never parses colors.
+class AnsiColor {
+   public:
+    consteval AnsiColor(const char* hex) {
+        if (hex[0] != '#') {
+            throw "expected #rrggbb";
+        }
+        append("\033[38;2;");
+        for (int i = 0; i < 3; i++) {
+            append_int(nibble(hex[1 + i * 2]) * 16 + nibble(hex[2 + i * 2]));
+            append(i < 2 ? ";" : "m");
+        }
+    }
+    constexpr operator std::string_view() const { return {data_, size_}; }
+
+   private:
+    static consteval int nibble(char c) {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        throw "invalid hex digit";
+    }
+    consteval void append(const char* s) {
+        while (*s) {
+            data_[size_++] = *s++;
+        }
+    }
+    consteval void append_int(int v) {
+        if (v >= 100) {
+            data_[size_++] = static_cast<char>('0' + v / 100);
+        }
+        if (v >= 10) {
+            data_[size_++] = static_cast<char>('0' + v / 10 % 10);
+        }
+        data_[size_++] = static_cast<char>('0' + v % 10);
+    }
+
+    char data_[sizeof("\033[38;2;255;255;255m")]{};
+    std::size_t size_{0};
+};
+
 class ColorScheme {
    public:
-    using Scheme = std::array<const char*, 5>;
+    using Scheme = std::array<AnsiColor, 5>;
+    struct NamedScheme {
+        std::string_view name;
+        Scheme colors;
+    };
+    struct Glyph {
+        std::string_view name;
+        const char* full;
+        const char* empty;
+    };
 
-    ColorScheme(std::string const& color);
-    static const std::map<std::string, Scheme> default_schemes;
-    static const std::string info;
-    static const std::string reset;
-    static const std::map<std::string, std::pair<const char*, const char*>>
-        blocks;
-    std::string level_color(CommitNumberLevel level) const;
+    ColorScheme(std::string_view name);
+
+    // Sorted by name, as listed in --help.
+    static constexpr std::array<NamedScheme, 9> default_schemes{{
+        {"blackwhite", {"#333333", "#707070", "#a0a0a0", "#d0d0d0", "#ffffff"}},
+        {"default", {"#333333", "#9be9a8", "#40c463", "#30a14e", "#216e39"}},
+        {"dracula", {"#282a36", "#50fa7b", "#ff79c6", "#bd93f9", "#6272a4"}},
+        {"github", {"#ebedf0", "#9be9a8", "#40c463", "#30a14e", "#216e39"}},
+        {"gold", {"#333333", "#FDEEDC", "#FFD8A9", "#F1A661", "#E38B29"}},
+        {"mint", {"#333333", "#5AFEAD", "#21B475", "#1D794B", "#294B36"}},
+        {"north", {"#333333", "#DBE2EF", "#3282B8", "#3F72AF", "#112D4E"}},
+        {"sunset", {"#333333", "#F67280", "#C06C84", "#6C5B7B", "#355C7D"}},
+        {"vibrant", {"#333333", "#F9ED69", "#F08A5D", "#B83B5E", "#6A2C70"}},
+    }};
+    static constexpr std::string_view info = "\033[38;2;100;100;100m";
+    static constexpr std::string_view reset = "\033[0m";
+    static constexpr std::array<Glyph, 6> blocks{{
+        {"block", "█", "█"},
+        {"diamond", "♦︎", "♦︎"},
+        {"dot", "•", "•"},
+        {"fisheye", "◉", "●"},
+        {"plus", "✚", "•"},
+        {"square", "◼︎", "◼︎"},
+    }};
+
+    // Throw std::invalid_argument for unknown names.
+    static Scheme const& scheme(std::string_view name);
+    static Glyph const& glyph(std::string_view name);
+
+    std::string_view level_color(CommitNumberLevel level) const;
 
    private:
-    Scheme current_color;
+    Scheme const* current_color;
 };
 
-class Terminal {
+enum class TerminalView {
+    HEATMAP,   /* days of the last weeks */
+    PUNCHCARD, /* weekday x hour of the day */
+};
+
+class Terminal : public Renderer {
    public:
     Terminal(std::string const& color_scheme, std::string const& glyph,
-             std::string const& author);
+             TerminalView view = TerminalView::HEATMAP);
     int columns() const;
-    std::string info_color() const;
-    std::string reset_color() const;
-    std::string level_color(CommitNumberLevel level) const;
-
-    void set_author(std::string const& author);
+    std::string_view info_color() const;
+    std::string_view reset_color() const;
+    std::string_view level_color(CommitNumberLevel level) const;
 
-    void display(
-        std::vector<std::pair<const std::chrono::sys_days, int>> commits);
+    void display(DayCounts const& commits) override;
+    void display_heatmap(DayCounts const& commits);
+    void display_punchcard(DayCounts const& commits);
 
     static std::string show_example(std::string const& color_scheme,
                                     std::string const& glyph);
@@ -50,9 +138,9 @@ class Terminal {
                                      std::string const& glyph);
 
    private:
-    std::string author_;
     ColorScheme color_scheme_;
-    std::pair<const char*, const char*> glyph_;
+    ColorScheme::Glyph glyph_;
+    TerminalView view_;
 };
 
 #endif  // __GIT_HEATMAP_TERMINAL_H__
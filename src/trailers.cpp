@@ -0,0 +1,111 @@
+#include "trailers.h"
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GIT_HEATMAP_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GIT_HEATMAP_NEON 1
+#endif
+
+static constexpr char key[] = "co-authored-by:";
+static constexpr std::size_t key_length = sizeof(key) - 1;
+
+std::string_view last_paragraph(std::string_view message) {
+    auto end = message.find_last_not_of(" \t\r\n");
+    if (end == std::string_view::npos) {
+        return {};
+    }
+    message = message.substr(0, end + 1);
+    auto blank = message.rfind("\n\n");
+    auto blank_crlf = message.rfind("\n\r\n");
+    if (blank == std::string_view::npos ||
+        (blank_crlf != std::string_view::npos && blank_crlf > blank)) {
+        blank = blank_crlf;
+    }
+    // The subject is never a trailer block.
+    if (blank == std::string_view::npos) {
+        return {};
+    }
+    return message.substr(message.find('\n', blank + 1) + 1);
+}
+
+// Compare with the lower case key; '|' 0x20 folds ASCII letters and leaves
+// '-' and ':' untouched.
+static bool is_trailer_at(std::string_view text, std::size_t pos) {
+    if (pos != 0 && text[pos - 1] != '\n') {
+        return false;
+    }
+    for (std::size_t i = 0; i < key_length; i++) {
+        if ((static_cast<unsigned char>(text[pos + i]) | 0x20) !=
+            static_cast<unsigned char>(key[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t find_coauthor_trailer(std::string_view text, std::size_t from) {
+    if (text.size() < key_length) {
+        return std::string_view::npos;
+    }
+    const char* p = text.data();
+    std::size_t i = from;
+    // Candidates have the first and the last byte of the key in place;
+    // both loads are folded to lower case with one OR.
+#if defined(GIT_HEATMAP_SSE2)
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i first = _mm_set1_epi8(key[0]);
+    const __m128i last = _mm_set1_epi8(key[key_length - 1]);
+    for (; i + 16 + key_length - 1 <= text.size(); i += 16) {
+        __m128i a = _mm_or_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)), lower);
+        __m128i b = _mm_or_si128(
+            _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(p + i + key_length - 1)),
+            lower);
+        auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            auto pos = i + std::countr_zero(mask);
+            if (is_trailer_at(text, pos)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+#elif defined(GIT_HEATMAP_NEON)
+    const uint8x16_t lower = vdupq_n_u8(0x20);
+    const uint8x16_t first = vdupq_n_u8(key[0]);
+    const uint8x16_t last = vdupq_n_u8(key[key_length - 1]);
+    for (; i + 16 + key_length - 1 <= text.size(); i += 16) {
+        uint8x16_t a = vorrq_u8(
+            vld1q_u8(reinterpret_cast<const uint8_t*>(p + i)), lower);
+        uint8x16_t b = vorrq_u8(
+            vld1q_u8(reinterpret_cast<const uint8_t*>(p + i + key_length - 1)),
+            lower);
+        uint8x16_t eq = vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last));
+        // Narrow to 4 bits per byte to get a movemask.
+        auto mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (mask != 0) {
+            auto pos = i + std::countr_zero(mask) / 4;
+            if (is_trailer_at(text, pos)) {
+                return pos;
+            }
+            mask &= ~(std::uint64_t{0xf} << (std::countr_zero(mask) & ~3));
+        }
+    }
+#endif
+    for (; i + key_length <= text.size(); i++) {
+        if ((static_cast<unsigned char>(p[i]) | 0x20) == key[0] &&
+            is_trailer_at(text, i)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
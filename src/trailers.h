@@ -0,0 +1,36 @@
+#ifndef __GIT_HEATMAP_TRAILERS_H__
+#define __GIT_HEATMAP_TRAILERS_H__
+
+#include <cstddef>
+#include <string_view>
+
+// The last paragraph of a commit message, where git keeps its trailers.
+std::string_view last_paragraph(std::string_view message);
+
+// Offset of the next line starting with "Co-authored-by:" (any case) at or
+// after `from`, or npos. Candidates are found 16 bytes at a time with SSE2
+// or NEON where available.
+std::size_t find_coauthor_trailer(std::string_view text, std::size_t from = 0);
+
+// Calls `f` with the email of every Co-authored-by trailer of a commit
+// message, as views into the message: nothing is allocated.
+template <typename F>
+void for_each_coauthor(std::string_view message, F&& f) {
+    constexpr std::size_t key_length = sizeof("co-authored-by:") - 1;
+    auto text = last_paragraph(message);
+    for (auto pos = find_coauthor_trailer(text); pos != std::string_view::npos;
+         pos = find_coauthor_trailer(text, pos + key_length)) {
+        auto end = text.find('\n', pos);
+        auto line = text.substr(pos, end == std::string_view::npos
+                                         ? std::string_view::npos
+                                         : end - pos);
+        auto open = line.find('<');
+        auto close = line.rfind('>');
+        if (open != std::string_view::npos &&
+            close != std::string_view::npos && open < close) {
+            f(line.substr(open + 1, close - open - 1));
+        }
+    }
+}
+
+#endif  // __GIT_HEATMAP_TRAILERS_H__
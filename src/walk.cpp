@@ -0,0 +1,50 @@
+#include "walk.h"
+
+void WorkQueue::push(std::vector<std::uint32_t>& from, std::size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.insert(queue_.end(), from.begin(), from.begin() + count);
+    }
+    from.erase(from.begin(), from.begin() + count);
+    cv_.notify_all();
+}
+
+bool WorkQueue::take(std::vector<std::uint32_t>& into, std::size_t max) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_++;
+    if (idle_ == workers_) {
+        cv_.notify_all();
+    }
+    cv_.wait(lock, [this] {
+        return stopped_ || !queue_.empty() || idle_ == workers_;
+    });
+    if (stopped_ || queue_.empty()) {
+        return false;
+    }
+    idle_--;
+    // A fair share, so the seeds do not all go to the first worker.
+    auto count = std::clamp<std::size_t>(queue_.size() / workers_, 1, max);
+    into.insert(into.end(), queue_.end() - count, queue_.end());
+    queue_.resize(queue_.size() - count);
+    return true;
+}
+
+void WorkQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+}
+
+std::size_t StackPrefetcher::giveable(std::vector<std::uint32_t> const& stack,
+                                      std::size_t max) const {
+    if (!packs_) {
+        return max;
+    }
+    std::size_t ret = 0;
+    while (ret < max && !requested_[stack[ret]]) {
+        ret++;
+    }
+    return ret;
+}
@@ -0,0 +1,545 @@
+#ifndef __GIT_HEATMAP_WALK_H__
+#define __GIT_HEATMAP_WALK_H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+#include <git2.h>
+
+#include "commit_graph.h"
+#include "debug.h"
+#include "prefetch.h"
+#include "repository.h"
+
+struct WalkOptions {
+    // Follow only the first parent of every commit.
+    bool first_parent{false};
+    // Skip commits with more than one parent.
+    bool no_merges{false};
+    // Only commits with a UTC commit time in [since, until) are visited;
+    // the caller widens the window by the largest time zone offset.
+    std::int64_t since{0};
+    std::int64_t until{0};
+    // With a commit-graph, keep the reads of up to `prefetch_depth`
+    // queued commits in flight through `packs` ahead of their lookup.
+    PackIndex const* packs{nullptr};
+    std::size_t prefetch_depth{0};
+};
+
+// Visits the commits reachable from `tips` inside the window, newest first.
+// `visit` is called with each git_commit* and inlined into the walk.
+//
+// With a commit-graph, parents, commit times and merge checks come from the
+// graph and only the commits handed to `visit` are inflated; the walk stops
+// exactly once every remaining corrected commit date is older than the
+// window. Commits newer than the graph, or every commit without one, go
+// through a time sorted git_revwalk, which stops after a run of commits
+// older than the window.
+template <typename Visit>
+void walk_history(git_repository* repo, CommitGraph const* graph,
+                  std::vector<git_oid> const& tips, WalkOptions const& options,
+                  Visit&& visit);
+
+// walk_history on `threads` workers (0: one per core), each with its own
+// git_repository from `repository`. `visit` is called with the worker index
+// and the commit, concurrently from different workers, in no particular
+// order.
+//
+// The commits above the graph and the first-parent chains below the tips
+// are walked first; every worker then takes chain commits and walks the
+// branches merged into them depth first, giving half of its stack to idle
+// workers. A commit is claimed once through a shared atomic bitset over
+// graph positions, and a branch is abandoned as soon as its corrected
+// commit date falls behind the window. Without a graph with corrected
+// dates, or with first_parent, this is walk_history on the calling thread.
+template <typename Visit>
+void walk_history_parallel(Repository& repository, CommitGraph const* graph,
+                           std::vector<git_oid> const& tips,
+                           WalkOptions const& options, std::size_t threads,
+                           Visit&& visit);
+
+// Which commits a walk visits and which of their parents it follows, from
+// WalkOptions::first_parent and no_merges. Chosen once per walk, so that
+// the walk loops hold no option checks.
+template <bool FirstParent, bool NoMerges>
+struct MergePolicy {
+    static constexpr bool first_parent = FirstParent;
+
+    // Whether a commit with `count` parents is left out.
+    static bool skip(unsigned int count) { return NoMerges && count > 1; }
+
+    // How many of the `count` parents of a commit are followed.
+    static unsigned int follow(unsigned int count) {
+        return FirstParent ? std::min(count, 1u) : count;
+    }
+    static void parents(CommitGraph const& graph, std::uint32_t pos,
+                        std::vector<std::uint32_t>& out) {
+        if constexpr (FirstParent) {
+            auto parent = graph.first_parent(pos);
+            if (parent != CommitGraph::NO_PARENT) {
+                out.push_back(parent);
+            }
+        } else {
+            graph.parents(pos, out);
+        }
+    }
+};
+
+// Calls f(std::type_identity<MergePolicy<...>>) for `options`.
+template <typename F>
+void with_merge_policy(WalkOptions const& options, F&& f) {
+    auto with_no_merges = [&](auto first_parent) {
+        constexpr bool FirstParent = decltype(first_parent)::value;
+        if (options.no_merges) {
+            f(std::type_identity<MergePolicy<FirstParent, true>>{});
+        } else {
+            f(std::type_identity<MergePolicy<FirstParent, false>>{});
+        }
+    };
+    if (options.first_parent) {
+        with_no_merges(std::true_type{});
+    } else {
+        with_no_merges(std::false_type{});
+    }
+}
+
+// The support of the walks below; not part of the interface.
+
+// After this many commits in a row older than the window, a walk without
+// corrected dates gives up on finding newer ones.
+constexpr int WALK_MAX_CHECK_COUNT = 100;
+
+struct OidHash {
+    std::size_t operator()(git_oid const& oid) const {
+        std::size_t ret;
+        std::memcpy(&ret, oid.id, sizeof(ret));
+        return ret;
+    }
+};
+struct OidEqual {
+    bool operator()(git_oid const& a, git_oid const& b) const {
+        return git_oid_equal(&a, &b);
+    }
+};
+
+inline git_commit_ptr lookup_commit(git_repository* repo,
+                                    git_oid const& oid) {
+    git_commit* c{nullptr};
+    if (0 == git_commit_lookup(&c, repo, &oid)) {
+        return git_commit_ptr(c);
+    }
+    return git_commit_ptr(nullptr);
+}
+
+// A time sorted revwalk from `tips`, simplified to first parents if asked.
+inline git_revwalk_ptr start_revwalk(git_repository* repo,
+                                     std::vector<git_oid> const& tips,
+                                     bool first_parent) {
+    git_revwalk_ptr walk = [](git_repository* r) {
+        git_revwalk* w{nullptr};
+        if (0 == git_revwalk_new(&w, r)) {
+            return git_revwalk_ptr(w);
+        }
+        return git_revwalk_ptr(nullptr);
+    }(repo);
+
+    if (!walk) {
+        throw std::runtime_error("Failed to create git walk");
+    }
+
+    for (auto const& tip : tips) {
+        git_revwalk_push(walk.get(), &tip);
+    }
+    // Time order alone lets libgit2 hand out commits incrementally, where
+    // a topological sort first walks the whole history.
+    git_revwalk_sorting(walk.get(), GIT_SORT_TIME);
+    if (first_parent) {
+        git_revwalk_simplify_first_parent(walk.get());
+    }
+    return walk;
+}
+
+// One bit per graph position, claimed by whichever worker sets it first.
+class VisitedSet {
+   public:
+    explicit VisitedSet(std::uint32_t size) : bits_((size + 63) / 64) {}
+
+    // True when `pos` was not visited before.
+    bool claim(std::uint32_t pos) {
+        auto bit = std::uint64_t{1} << (pos & 63);
+        return (bits_[pos >> 6].fetch_or(bit, std::memory_order_relaxed) &
+                bit) == 0;
+    }
+
+   private:
+    std::vector<std::atomic<std::uint64_t>> bits_;
+};
+
+// Workers walk depth first from a private stack and only go through the
+// shared queue to take work, or to hand half of theirs to idle workers.
+class WorkQueue {
+   public:
+    explicit WorkQueue(std::size_t workers) : workers_{workers} {}
+
+    void push(std::vector<std::uint32_t>& from, std::size_t count);
+
+    // Blocks until there is work, or returns false once every worker is
+    // idle with nothing queued.
+    bool take(std::vector<std::uint32_t>& into, std::size_t max);
+
+    bool hungry() const { return idle_.load(std::memory_order_relaxed) > 0; }
+
+    void stop();
+
+   private:
+    std::size_t const workers_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::uint32_t> queue_;
+    std::atomic<std::size_t> idle_{0};
+    bool stopped_{false};
+};
+
+// Keeps the reads of the candidate commits among the top `depth` entries of
+// a worker's stack, the next ones it pops, in flight. Each commit is
+// requested once, and the commits it requested are never handed to
+// other workers, which would request them again.
+class StackPrefetcher {
+   public:
+    StackPrefetcher(PackIndex const* packs, std::size_t depth,
+                    std::uint32_t graph_size)
+        : packs_{depth > 0 ? packs : nullptr},
+          depth_{depth},
+          requested_(packs_ ? graph_size : 0, false) {}
+
+    template <typename Candidate>
+    void update(CommitGraph const& graph,
+                std::vector<std::uint32_t> const& stack,
+                Candidate&& candidate) {
+        if (!packs_) {
+            return;
+        }
+        auto window = std::min(depth_, stack.size());
+        for (auto it = stack.end() - window; it != stack.end(); ++it) {
+            if (!requested_[*it] && candidate(*it)) {
+                requested_[*it] = true;
+                packs_->prefetch(graph.oid(*it));
+            }
+        }
+    }
+
+    // How many entries from the bottom of the stack, at most `max`, can be
+    // handed to other workers.
+    std::size_t giveable(std::vector<std::uint32_t> const& stack,
+                         std::size_t max) const;
+
+   private:
+    PackIndex const* packs_;
+    std::size_t depth_;
+    std::vector<bool> requested_;
+};
+
+template <typename Merges, typename Visit>
+void walk_revwalk(git_repository* repo, std::vector<git_oid> const& tips,
+                  WalkOptions const& options, Visit& visit) {
+    auto walk = start_revwalk(repo, tips, Merges::first_parent);
+
+    git_oid oid;
+    int check_count = 0;
+    while (0 == git_revwalk_next(&oid, walk.get())) {
+        auto commit = lookup_commit(repo, oid);
+        if (!commit) {
+            break;
+        }
+        auto time = git_commit_time(commit.get());
+        if (time < options.since) {
+            if (check_count++ > WALK_MAX_CHECK_COUNT) {
+                break;
+            }
+            continue;
+        }
+        check_count = 0;
+        if (time >= options.until) {
+            continue;
+        }
+        if (Merges::skip(git_commit_parentcount(commit.get()))) {
+            continue;
+        }
+        visit(commit.get());
+    }
+}
+
+template <typename Merges, typename Visit>
+void walk_graph(git_repository* repo, CommitGraph const& graph,
+                std::vector<git_oid> const& tips, WalkOptions const& options,
+                Visit& visit) {
+    // Commits the graph does not know yet sort before all others.
+    constexpr auto NEWEST = std::numeric_limits<std::int64_t>::max();
+    struct Entry {
+        std::int64_t key;
+        std::uint32_t pos;  // NO_PARENT when not in the graph
+        git_oid oid;
+        bool candidate;  // to be visited, known for graph commits only
+        bool operator<(Entry const& other) const { return key < other.key; }
+    };
+
+    bool const exact = graph.has_corrected_dates();
+    Prefetcher prefetcher{options.packs, options.prefetch_depth};
+    std::priority_queue<Entry> queue;
+    std::vector<bool> seen(graph.size(), false);
+    std::unordered_set<git_oid, OidHash, OidEqual> seen_outside;
+    std::vector<std::uint32_t> parents;
+
+    auto push_pos = [&](std::uint32_t pos) {
+        if (!seen[pos]) {
+            seen[pos] = true;
+            auto time = graph.commit_time(pos);
+            bool candidate = time >= options.since && time < options.until &&
+                             !Merges::skip(graph.parent_count(pos));
+            if (candidate) {
+                prefetcher.want(graph.oid(pos));
+            }
+            queue.push({graph.corrected_date(pos), pos, {}, candidate});
+        }
+    };
+    auto push = [&](git_oid const& oid) {
+        if (auto pos = graph.find(oid)) {
+            push_pos(*pos);
+        } else if (seen_outside.insert(oid).second) {
+            queue.push({NEWEST, CommitGraph::NO_PARENT, oid, false});
+        }
+    };
+    for (auto const& tip : tips) {
+        push(tip);
+    }
+
+    int check_count = 0;
+    while (!queue.empty()) {
+        auto entry = queue.top();
+        queue.pop();
+
+        if (entry.pos == CommitGraph::NO_PARENT) {
+            auto commit = lookup_commit(repo, entry.oid);
+            if (!commit) {
+                continue;
+            }
+            auto time = git_commit_time(commit.get());
+            auto count = git_commit_parentcount(commit.get());
+            if (time >= options.since && time < options.until &&
+                !Merges::skip(count)) {
+                visit(commit.get());
+            }
+            for (unsigned int i = 0, n = Merges::follow(count); i < n; i++) {
+                push(*git_commit_parent_id(commit.get(), i));
+            }
+            continue;
+        }
+
+        // Ancestors never have a larger corrected date, so nothing left in
+        // the queue can reach into the window.
+        if (exact && entry.key < options.since) {
+            break;
+        }
+        auto time = graph.commit_time(entry.pos);
+        if (!exact) {
+            if (time < options.since) {
+                if (check_count++ > WALK_MAX_CHECK_COUNT) {
+                    break;
+                }
+            } else {
+                check_count = 0;
+            }
+        }
+
+        if (entry.candidate) {
+            if (auto commit = lookup_commit(repo, graph.oid(entry.pos))) {
+                visit(commit.get());
+            }
+            prefetcher.done();
+        }
+
+        parents.clear();
+        Merges::parents(graph, entry.pos, parents);
+        for (auto parent : parents) {
+            push_pos(parent);
+        }
+    }
+}
+
+template <typename Merges, typename Visit>
+void walk_parallel(Repository& repository, Repository::Handle repo,
+                   CommitGraph const& graph, std::vector<git_oid> const& tips,
+                   WalkOptions const& options, std::size_t threads,
+                   Visit& visit) {
+    static_assert(!Merges::first_parent, "a first-parent walk is serial");
+    auto in_window = [&](std::int64_t time) {
+        return time >= options.since && time < options.until;
+    };
+    VisitedSet visited{graph.size()};
+    std::vector<std::uint32_t> seeds;
+
+    // Commits newer than the graph are walked here, down to the graph.
+    std::vector<git_oid> pending{tips};
+    std::unordered_set<git_oid, OidHash, OidEqual> seen_outside;
+    while (!pending.empty()) {
+        auto oid = pending.back();
+        pending.pop_back();
+        if (auto pos = graph.find(oid)) {
+            if (visited.claim(*pos)) {
+                seeds.push_back(*pos);
+            }
+            continue;
+        }
+        if (!seen_outside.insert(oid).second) {
+            continue;
+        }
+        auto commit = lookup_commit(repo.get(), oid);
+        if (!commit) {
+            continue;
+        }
+        auto count = git_commit_parentcount(commit.get());
+        if (in_window(git_commit_time(commit.get())) && !Merges::skip(count)) {
+            visit(0, commit.get());
+        }
+        for (unsigned int i = 0; i < count; i++) {
+            pending.push_back(*git_commit_parent_id(commit.get(), i));
+        }
+    }
+
+    // The first-parent chains below the tips cut the window into time
+    // ordered segments; each seeds the side branches merged into it.
+    for (std::size_t i = 0, n = seeds.size(); i < n; i++) {
+        for (auto pos = graph.first_parent(seeds[i]);
+             pos != CommitGraph::NO_PARENT &&
+             graph.corrected_date(pos) >= options.since &&
+             visited.claim(pos);
+             pos = graph.first_parent(pos)) {
+            seeds.push_back(pos);
+        }
+    }
+    DEBUG_LOG("parallel walk: " << seeds.size() << " seeds, " << threads
+                                << " threads");
+
+    constexpr std::size_t BATCH = 64;
+    WorkQueue queue{threads};
+    queue.push(seeds, seeds.size());
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto candidate = [&](std::uint32_t pos) {
+        return in_window(graph.commit_time(pos)) &&
+               !Merges::skip(graph.parent_count(pos));
+    };
+    auto work = [&](std::size_t index, git_repository* r) {
+        std::vector<std::uint32_t> stack;
+        std::vector<std::uint32_t> parents;
+        StackPrefetcher prefetcher{options.packs, options.prefetch_depth,
+                                   graph.size()};
+        try {
+            while (queue.take(stack, BATCH)) {
+                while (!stack.empty()) {
+                    prefetcher.update(graph, stack, candidate);
+                    auto pos = stack.back();
+                    stack.pop_back();
+                    if (candidate(pos)) {
+                        if (auto commit = lookup_commit(r, graph.oid(pos))) {
+                            visit(index, commit.get());
+                        }
+                    }
+                    parents.clear();
+                    graph.parents(pos, parents);
+                    for (auto parent : parents) {
+                        if (graph.corrected_date(parent) >= options.since &&
+                            visited.claim(parent)) {
+                            stack.push_back(parent);
+                        }
+                    }
+                    if (stack.size() >= 2 * BATCH && queue.hungry()) {
+                        auto count =
+                            prefetcher.giveable(stack, stack.size() / 2);
+                        if (count > 0) {
+                            queue.push(stack, count);
+                        }
+                    }
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = std::current_exception();
+            queue.stop();
+        }
+    };
+
+    std::vector<Repository::Handle> handles;
+    handles.push_back(std::move(repo));
+    for (std::size_t i = 1; i < threads; i++) {
+        handles.push_back(repository.acquire());
+    }
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work, i, handles[i].get());
+    }
+    work(0, handles[0].get());
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+template <typename Visit>
+void walk_history(git_repository* repo, CommitGraph const* graph,
+                  std::vector<git_oid> const& tips, WalkOptions const& options,
+                  Visit&& visit) {
+    with_merge_policy(options, [&](auto merges) {
+        using Merges = typename decltype(merges)::type;
+        if (graph) {
+            DEBUG_LOG("walking with the commit-graph");
+            walk_graph<Merges>(repo, *graph, tips, options, visit);
+        } else {
+            walk_revwalk<Merges>(repo, tips, options, visit);
+        }
+    });
+}
+
+template <typename Visit>
+void walk_history_parallel(Repository& repository, CommitGraph const* graph,
+                           std::vector<git_oid> const& tips,
+                           WalkOptions const& options, std::size_t threads,
+                           Visit&& visit) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto repo = repository.acquire();
+    // Without corrected dates no commit proves its ancestors too old, and
+    // a first-parent walk is a single chain: neither splits.
+    if (threads == 1 || !graph || !graph->has_corrected_dates() ||
+        options.first_parent) {
+        walk_history(repo.get(), graph, tips, options,
+                     [&](git_commit* commit) { visit(0, commit); });
+        return;
+    }
+    if (options.no_merges) {
+        walk_parallel<MergePolicy<false, true>>(
+            repository, std::move(repo), *graph, tips, options, threads, visit);
+    } else {
+        walk_parallel<MergePolicy<false, false>>(
+            repository, std::move(repo), *graph, tips, options, threads, visit);
+    }
+}
+
+#endif  // __GIT_HEATMAP_WALK_H__